@@ -3,19 +3,68 @@
 #include "webgpu-utils.h"
 
 #include <GLFW/glfw3.h>
+#include <algorithm>
 #include <cassert>
+#include <cmath>
+#include <filesystem>
 #include <iostream>
+#include <string>
+#include <system_error>
 #include <vector>
 #include "ResourceManager.h"
+#include "Geometry.h"
+#include "GeometryStreamer.h"
+#include "MeshCache.h"
+#include "ResourceLoader.h"
+#include "ShaderPreprocessor.h"
 // In Application.cpp
 #include <glfw3webgpu.h>
 
+namespace
+{
+	const char* const ShaderPath = RESOURCE_DIR "/shader.wgsl";
+	const char* const GeometryPath = RESOURCE_DIR "/pyramid.txt";
+	// Built by tools/ResourcePacker.cpp, used instead of the loose files if present
+	const char* const ResourcePackPath = RESOURCE_DIR ".pack";
+	constexpr int GeometryDimensions = 3;
+	// Entry points of shader.wgsl
+	const std::vector<std::string> RenderEntryPoints = { "vs_main", "fs_main" };
+	const char* const CullEntryPoint = "cs_cull";
+
+	// Size of the window and of the render targets
+	constexpr uint32_t WindowWidth = 640;
+	constexpr uint32_t WindowHeight = 480;
+
+	// Camera, whose clipping planes are also given to the shader
+	constexpr float Pi = 3.14159265359f;
+	constexpr float CameraFocalLength = 640.0f / 480.0f;
+	constexpr float CameraNear = 0.01f;
+	constexpr float CameraFar = 100.0f;
+	// Uniform scale of the model transform
+	constexpr float ModelScale = 0.3f;
+	// Distance between the centers of the orbits of two neighbour copies,
+	// enough for their orbits not to overlap
+	constexpr float ObjectSpacing = 1.5f;
+	// Multiplies the vertex colors
+	const std::array<float, 4> ObjectColor = { 0.0f, 1.0f, 0.4f, 1.0f };
+
+	// Shader variant matching how the geometry is processed
+	ShaderFeatures shaderFeaturesFor(GeometryProcessing processing)
+	{
+		ShaderFeatures features = ShaderFeature_None;
+		if (processing & GeometryProcessing_Meshlets) {
+			features |= ShaderFeature_MeshletCulling;
+		}
+		return features;
+	}
+}
+
 bool Application::Initialize()
 {
 	glfwInit();
 	glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API); // <-- extra info for glfwCreateWindow
 	glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
-	m_window = glfwCreateWindow(640, 480, "Learn WebGPU", nullptr, nullptr);
+	m_window = glfwCreateWindow(WindowWidth, WindowHeight, "Learn WebGPU", nullptr, nullptr);
 
 	// Instance setup
 	m_instance = wgpuCreateInstance(nullptr);
@@ -41,7 +90,7 @@ bool Application::Initialize()
 	WGPUTextureDescriptor depthTextureDesc = WGPU_TEXTURE_DESCRIPTOR_INIT;
 	depthTextureDesc.label = toWgpuStringView("Z Buffer");
 	depthTextureDesc.usage = WGPUTextureUsage_RenderAttachment;
-	depthTextureDesc.size = { 640, 480, 1 };
+	depthTextureDesc.size = { WindowWidth, WindowHeight, 1 };
 	depthTextureDesc.format = m_depthTextureFormat;
 	WGPUTexture depthTexture = wgpuDeviceCreateTexture(m_device, &depthTextureDesc);
 	// Create the view of the depth texture manipulated by the rasterizer
@@ -53,30 +102,310 @@ bool Application::Initialize()
 	// We no longer need to access the adapter once we have the device
 	wgpuAdapterRelease(adapter);
 
+	m_camera.setViewport(WindowWidth, WindowHeight);
+	m_camera.setPerspective(CameraFocalLength, CameraNear, CameraFar);
+	// Tilt the view point by three 8th of turn, then step back so that the
+	// object is in front of it
+	m_camera.setView(Mat4::translation(0.0f, 0.0f, 2.0f) * Mat4::rotationX(-3.0f * Pi / 4.0f));
+
+	m_shaderModules = std::make_unique<ShaderModuleCache>(m_device);
+	m_pipelines = std::make_unique<RenderPipelineCache>(m_device);
+	m_layouts = std::make_unique<PipelineLayoutCache>(m_device);
+	m_bindGroups = std::make_unique<BindGroupCache>(m_device);
+	// MyUniforms, one block per frame from m_uniforms shared by every
+	// instance, whose own data is in the instance buffer
+	m_layouts->setDynamicOffset(0, 0);
+
+	std::error_code ec;
+	if (std::filesystem::exists(ResourcePackPath, ec)) {
+		m_usesResourcePack = ResourceManager::mountPack(ResourcePackPath, RESOURCE_DIR);
+	}
+
+#ifndef __EMSCRIPTEN__
+	// Preloaded resources never change in the browser, and packed ones are
+	// not edited in place. Shader files are watched once their includes are
+	// known (see WatchShaderFiles()).
+	if (m_hotReload && !m_usesResourcePack) {
+		m_fileWatcher.watch(GeometryPath);
+	}
+#endif
 
 
 	// At the end of Initialize()
-	if (!InitializePipeline()) return false;
+	if (m_asyncLoading) {
+		// Frames are presented right away, the scene shows up once its
+		// resources are loaded (see OnResourceLoaded())
+		StartLoading();
+		return true;
+	}
+
+	// Buffers come first since the vertex layout of the pipeline depends on
+	// how the loaded geometry is encoded.
 	if (!InitializeBuffers()) return false;
+	std::cout << "Creating shader module..." << std::endl;
+	const ShaderFeatures shaderFeatures = shaderFeaturesFor(m_geometryProcessing);
+	PreprocessedShader shader;
+	if (!ShaderPreprocessor::preprocess(ShaderPath, ShaderPreprocessor::definesFor(shaderFeatures), shader)) return false;
+	WatchShaderFiles(shader);
+	return InitializeScene(m_shaderModules->acquireVariant(ShaderPath, shaderFeatures, shader));
+}
+
+void Application::StartLoading()
+{
+	m_loader = std::make_unique<ResourceLoader>();
+	auto onLoaded = [this](auto& /* handle */) { OnResourceLoaded(); };
+	m_shaderHandle = m_loader->loadShader(ShaderPath, shaderFeaturesFor(m_geometryProcessing), onLoaded);
+	m_geometryHandle = m_loader->openGeometry(GeometryPath, GeometryDimensions, m_geometryProcessing, onLoaded);
+}
+
+void Application::OnResourceLoaded()
+{
+	// Called on the render thread, from MainLoop(). The ResourceManager has
+	// already reported what went wrong.
+	if (m_shaderHandle->hasFailed() || m_geometryHandle->hasFailed()) {
+		std::cerr << "Could not load the scene!" << std::endl;
+		glfwSetWindowShouldClose(m_window, GLFW_TRUE);
+		return;
+	}
+	if (!m_shaderHandle->isReady() || !m_geometryHandle->isReady()) return;
+
+	GeometrySource& source = m_geometryHandle->value();
+	if (source.streamer) {
+		// The scene is set up once the last chunk is uploaded, see MainLoop()
+		BeginGeometryStream(std::move(source.streamer), source.cacheKey);
+	}
+	else {
+		UploadGeometry(source.geometry);
+		FinishLoading();
+	}
+	// The CPU side copy is no longer needed
+	m_geometryHandle.reset();
+}
+
+void Application::FinishLoading()
+{
+	std::cout << "Creating shader module..." << std::endl;
+	WatchShaderFiles(m_shaderHandle->value());
+	WGPUShaderModule shaderModule = m_shaderModules->acquireVariant(ShaderPath, shaderFeaturesFor(m_geometryProcessing), m_shaderHandle->value());
+	if (!InitializeScene(shaderModule)) {
+		glfwSetWindowShouldClose(m_window, GLFW_TRUE);
+	}
+	m_shaderHandle.reset();
+}
 
+bool Application::InitializeScene(WGPUShaderModule shaderModule)
+{
+	std::cout << "Shader module: " << shaderModule << std::endl;
+	if (shaderModule == nullptr) return false;
+
+	InitializeLods();
+
+	// The module is kept to rebuild pipelines on hot reload
+	m_shaderModule = shaderModule;
+	if (!InitializePipeline(shaderModule)) return false;
+
+	InitializeUniforms();
 	InitializeBindGroups();
+	m_sceneReady = true;
 	return true;
 }
 
+void Application::InitializeLods()
+{
+	// Without simplification, the base mesh is the only level of detail. Its
+	// bounds come from the loader rather than from the simplifier.
+	if (m_lods.empty()) {
+		MeshLod base = {};
+		if (!m_bounds.empty()) {
+			base.center = m_bounds.center;
+			base.radius = m_bounds.radius;
+		}
+		base.indexCount = m_indexCount;
+		base.meshletCount = m_meshletCount;
+		m_lods.push_back(base);
+	}
+	// Until the next frame selects levels again
+	m_batches.clear();
+}
+
+void Application::WatchShaderFiles(const PreprocessedShader& shader)
+{
+#ifndef __EMSCRIPTEN__
+	if (!m_hotReload || m_usesResourcePack) return;
+	for (const std::filesystem::path& path : shader.dependencies) {
+		m_fileWatcher.watch(path);
+	}
+#else
+	(void)shader;
+#endif
+}
+
+void Application::ProcessFileChanges()
+{
+	// Reloads go through the background loader like the initial load, and
+	// are swapped in by its completion callbacks at a frame boundary
+	bool shaderChanged = false;
+	for (const std::filesystem::path& path : m_fileWatcher.poll()) {
+		if (!m_loader) {
+			m_loader = std::make_unique<ResourceLoader>();
+		}
+		std::cout << "Reloading " << path << "..." << std::endl;
+		if (path == GeometryPath) {
+			m_loader->loadGeometry(GeometryPath, GeometryDimensions, m_geometryProcessing, [this](LoadHandle<Geometry>& handle) {
+				if (handle.isReady()) ReloadGeometry(handle.value());
+			});
+		}
+		else {
+			// The shader or one of its includes
+			m_shaderModules->invalidate(path);
+			shaderChanged = true;
+		}
+	}
+	if (shaderChanged) {
+		m_loader->loadShader(ShaderPath, shaderFeaturesFor(m_geometryProcessing), [this](LoadHandle<PreprocessedShader>& handle) {
+			if (handle.isReady()) ReloadShader(handle.value());
+		});
+	}
+}
+
+void Application::ReloadShader(const PreprocessedShader& shader)
+{
+	// It may include new files
+	WatchShaderFiles(shader);
+
+	// Compilation errors are captured by an error scope rather than reported
+	// as uncaptured errors, and the current pipelines stay in use until the
+	// new module is known to be valid.
+	wgpuDevicePushErrorScope(m_device, WGPUErrorFilter_Validation);
+	ShaderReload* reload = new ShaderReload{};
+	reload->geometryGeneration = m_geometryGeneration;
+	// An unchanged source (e.g. the file was only touched) gets the current
+	// module back from the cache
+	reload->shaderModule = m_shaderModules->acquireVariant(ShaderPath, shaderFeaturesFor(m_geometryProcessing), shader);
+	reload->cullPipeline = m_meshletCount > 0 ? CreateCullingPipeline(reload->shaderModule) : nullptr;
+
+	WGPUPopErrorScopeCallbackInfo callbackInfo = WGPU_POP_ERROR_SCOPE_CALLBACK_INFO_INIT;
+	callbackInfo.mode = WGPUCallbackMode_AllowProcessEvents;
+	callbackInfo.callback = [](
+		WGPUPopErrorScopeStatus status,
+		WGPUErrorType type,
+		struct WGPUStringView message,
+		void* userdata1,
+		void* userdata2
+		) {
+			std::unique_ptr<ShaderReload> reload(static_cast<ShaderReload*>(userdata2));
+			bool valid = status == WGPUPopErrorScopeStatus_Success && type == WGPUErrorType_NoError;
+			if (!valid) {
+				std::cerr << "Could not reload shader, keeping the previous one: " << toStdStringView(message) << std::endl;
+			}
+			static_cast<Application*>(userdata1)->FinishShaderReload(*reload, valid);
+		};
+	callbackInfo.userdata1 = this;
+	callbackInfo.userdata2 = reload;
+	wgpuDevicePopErrorScope(m_device, callbackInfo);
+}
+
+bool Application::UsesCurrentLayouts(WGPUShaderModule shaderModule)
+{
+	// Layouts are shared by content, so comparing handles compares content
+	const ShaderReflection* reflection = m_shaderModules->reflection(shaderModule);
+	if (reflection == nullptr) return false;
+	if (m_layouts->pipelineLayout(*reflection, RenderEntryPoints) != m_layout) return false;
+	return m_cullLayout == nullptr || m_layouts->pipelineLayout(*reflection, { CullEntryPoint }) == m_cullLayout;
+}
+
+void Application::FinishShaderReload(const ShaderReload& reload, bool valid)
+{
+	// Bind groups are created once for the layouts of the first shader
+	if (valid && !UsesCurrentLayouts(reload.shaderModule)) {
+		std::cerr << "Could not reload shader, its bindings changed: restart to apply it" << std::endl;
+		valid = false;
+	}
+	if (!valid) {
+		if (reload.cullPipeline) wgpuComputePipelineRelease(reload.cullPipeline);
+		if (reload.shaderModule) m_shaderModules->release(reload.shaderModule);
+		return;
+	}
+
+	if (m_cullPipeline) wgpuComputePipelineRelease(m_cullPipeline);
+	m_shaderModules->release(m_shaderModule);
+	m_shaderModule = reload.shaderModule;
+	if (reload.geometryGeneration == m_geometryGeneration) {
+		m_cullPipeline = reload.cullPipeline;
+	}
+	else {
+		// The geometry was reloaded in the meantime, possibly with another
+		// encoding that the pipeline was not built for
+		if (reload.cullPipeline) wgpuComputePipelineRelease(reload.cullPipeline);
+		m_cullPipeline = m_meshletCount > 0 ? CreateCullingPipeline(m_shaderModule) : nullptr;
+	}
+	// The previous render pipeline is drawn with until this one is compiled
+	RequestRenderPipeline(m_shaderModule);
+	std::cout << "Reloaded " << ShaderPath << " (render pipelines: "
+		<< m_pipelines->hitCount() << " reused, " << m_pipelines->missCount() << " created)" << std::endl;
+}
+
+void Application::ReloadGeometry(const Geometry& geometry)
+{
+	const VertexLayout previousLayout = m_vertexLayout;
+	const WGPUIndexFormat previousIndexFormat = m_indexFormat;
+	const bool hadMeshlets = m_meshletCount > 0;
+
+	// Frames in flight hold their own references to the previous buffers
+	ReleaseGeometryBuffers();
+	UploadGeometry(geometry);
+	InitializeLods();
+	++m_geometryGeneration;
+
+	// Pipelines only depend on how the geometry is encoded, which usually
+	// stays the same. Otherwise the current one cannot fetch the new
+	// vertices, and the mesh is not drawn until the next one is compiled.
+	if (!m_vertexLayout.sameFormat(previousLayout)) {
+		if (m_pipeline) m_pipelines->release(m_pipeline);
+		m_pipeline = nullptr;
+		RequestRenderPipeline(m_shaderModule);
+	}
+	if (m_meshletCount > 0) {
+		if (!hadMeshlets || previousIndexFormat != m_indexFormat) {
+			if (m_cullPipeline) wgpuComputePipelineRelease(m_cullPipeline);
+			m_cullPipeline = CreateCullingPipeline(m_shaderModule);
+		}
+		CreateCullBindGroup();
+	}
+	std::cout << "Reloaded " << GeometryPath << std::endl;
+}
+
 void Application::Terminate()
 {
-	wgpuBufferRelease(m_pointBuffer);
-	wgpuBufferRelease(m_indexBuffer);
+	// Wait for the background loads that are running, and drop the others
+	m_loader.reset();
+	m_geometryStream.reset();
+	ResourceManager::unmountPacks();
+
+	ReleaseGeometryBuffers();
 	wgpuBufferRelease(m_vertexBuffer);
 	wgpuTextureViewRelease(m_depthTextureView);
-	wgpuRenderPipelineRelease(m_pipeline);
+	if (m_pipeline) m_pipelines->release(m_pipeline);
+	if (m_sceneReady) {
+		const ShadowBuffer::Stats& uniformStats = m_uniforms->uploadStats();
+		const ShadowBuffer::Stats& instanceStats = m_instanceBuffer->stats();
+		std::cout << "Uniform uploads: " << uniformStats.uploadCount << " writes, " << uniformStats.uploadedBytes << " bytes, " << uniformStats.unchangedBytes << " bytes unchanged" << std::endl;
+		std::cout << "Instance uploads: " << instanceStats.uploadCount << " writes, " << instanceStats.uploadedBytes << " bytes, " << instanceStats.unchangedBytes << " bytes unchanged" << std::endl;
+		m_bindGroups->evict(m_instanceBuffer->buffer());
+		m_instanceBuffer.reset();
+	}
+	// Drops its references to the remaining buffers and layouts
+	m_bindGroups.reset();
+	m_uniforms.reset();
+	m_pipelines.reset();
+	if (m_shaderModule) m_shaderModules->release(m_shaderModule);
+	m_shaderModules.reset();
+	if (m_cullPipeline) wgpuComputePipelineRelease(m_cullPipeline);
+	m_layouts.reset();
 	wgpuSurfaceUnconfigure(m_surface);
 	wgpuQueueRelease(m_queue);
 	wgpuSurfaceRelease(m_surface);
 	wgpuDeviceRelease(m_device);
-	wgpuBufferRelease(m_uniformBuffer);
-	wgpuPipelineLayoutRelease(m_layout);
-	wgpuBindGroupLayoutRelease(m_bindGroupLayout);
 	glfwDestroyWindow(m_window);
 	glfwTerminate();
 
@@ -121,6 +450,11 @@ void Application::RenderPassEncoder(const WGPUTextureView& targetView)
 	encoderDesc.label = toWgpuStringView("My command encoder");
 	WGPUCommandEncoder encoder = wgpuDeviceCreateCommandEncoder(m_device, &encoderDesc);
 
+	// Cull meshlets before drawing the ones that are left
+	if (m_sceneReady && CullsMeshlets()) {
+		CullingPassEncoder(encoder);
+	}
+
 	// renderpass descriptor
 	WGPURenderPassDescriptor renderPassDesc = WGPU_RENDER_PASS_DESCRIPTOR_INIT;
 
@@ -151,16 +485,10 @@ void Application::RenderPassEncoder(const WGPUTextureView& targetView)
 
 	// render pass encoder
 	WGPURenderPassEncoder renderPass = wgpuCommandEncoderBeginRenderPass(encoder, &renderPassDesc);
-	wgpuRenderPassEncoderSetPipeline(renderPass, m_pipeline);
-	// Set vertex buffers while encoding the render pass
-	wgpuRenderPassEncoderSetVertexBuffer(renderPass, 0, m_pointBuffer, 0, wgpuBufferGetSize(m_pointBuffer));
-	wgpuRenderPassEncoderSetIndexBuffer(renderPass, m_indexBuffer, WGPUIndexFormat_Uint16, 0, wgpuBufferGetSize(m_indexBuffer));
-
-	wgpuRenderPassEncoderSetBindGroup(renderPass, 0, m_bindGroup, 0, nullptr);
-
-	// Replace `draw()` with `drawIndexed()` and `m_vertexCount` with `m_indexCount`
-	// The extra argument is an offset within the index buffer.
-	wgpuRenderPassEncoderDrawIndexed(renderPass, m_indexCount, 1, 0, 0, 0);
+	// Until the scene is loaded, frames are only cleared
+	if (m_sceneReady) {
+		DrawScene(renderPass);
+	}
 
 	wgpuRenderPassEncoderEnd(renderPass);
 	wgpuRenderPassEncoderRelease(renderPass);
@@ -181,14 +509,167 @@ void Application::RenderPassEncoder(const WGPUTextureView& targetView)
 
 }
 
+void Application::DrawScene(WGPURenderPassEncoder renderPass)
+{
+	// Skipped rather than waited for while the pipeline compiles
+	if (m_pipeline == nullptr) return;
+
+	wgpuRenderPassEncoderSetPipeline(renderPass, m_pipeline);
+	// Set vertex buffers while encoding the render pass
+	wgpuRenderPassEncoderSetVertexBuffer(renderPass, 0, m_pointBuffer, 0, wgpuBufferGetSize(m_pointBuffer));
+
+	if (m_batches.empty() || m_frameUniformOffset == UniformArena::InvalidOffset) return;
+	wgpuRenderPassEncoderSetBindGroup(renderPass, 0, m_bindGroup, 1, &m_frameUniformOffset);
+
+	if (CullsMeshlets()) {
+		// The culling pass wrote both the indices and the index count
+		wgpuRenderPassEncoderSetIndexBuffer(renderPass, m_culledIndexBuffer, WGPUIndexFormat_Uint32, 0, wgpuBufferGetSize(m_culledIndexBuffer));
+		wgpuRenderPassEncoderDrawIndexedIndirect(renderPass, m_drawArgsBuffer, 0);
+		return;
+	}
+
+	// The index format depends on the vertex count of the loaded mesh
+	wgpuRenderPassEncoderSetIndexBuffer(renderPass, m_indexBuffer, m_indexFormat, 0, wgpuBufferGetSize(m_indexBuffer));
+	for (const InstanceBatch& batch : m_batches) {
+		// One draw for all the visible copies at this level of detail: the
+		// vertex shader reads the transform and color of each one from the
+		// instances buffer, starting at firstInstance. The index offset is
+		// where the level of detail starts within the index buffer.
+		const MeshLod& lod = m_lods[batch.lod];
+		wgpuRenderPassEncoderDrawIndexed(renderPass, lod.indexCount, batch.instanceCount, lod.indexOffset, 0, batch.firstInstance);
+	}
+}
+
+bool Application::CullsMeshlets() const
+{
+	// The culling pass writes a single list of indices, for the first
+	// instance. Nothing is culled when it is not visible anyway.
+	return m_meshletCount > 0 && m_objects.size() == 1 && !m_batches.empty();
+}
+
+void Application::CullingPassEncoder(WGPUCommandEncoder encoder)
+{
+	// Reset the draw arguments, the culling pass accumulates the index count.
+	// Queue writes are executed before the commands submitted after them.
+	const uint32_t drawArgs[5] = {
+		0, // indexCount
+		1, // instanceCount
+		0, // firstIndex
+		0, // baseVertex
+		0, // firstInstance
+	};
+	wgpuQueueWriteBuffer(m_queue, m_drawArgsBuffer, 0, drawArgs, sizeof(drawArgs));
+
+	// Only the meshlets of the current level of detail are culled
+	const MeshLod& lod = m_lods[m_batches.front().lod];
+	const uint32_t cullParams[4] = { lod.meshletOffset, lod.meshletCount, 0, 0 };
+	wgpuQueueWriteBuffer(m_queue, m_cullParamsBuffer, 0, cullParams, sizeof(cullParams));
+	if (lod.meshletCount == 0) return;
+
+	WGPUComputePassDescriptor computePassDesc = WGPU_COMPUTE_PASS_DESCRIPTOR_INIT;
+	computePassDesc.label = toWgpuStringView("Meshlet culling");
+	WGPUComputePassEncoder computePass = wgpuCommandEncoderBeginComputePass(encoder, &computePassDesc);
+	wgpuComputePassEncoderSetPipeline(computePass, m_cullPipeline);
+	wgpuComputePassEncoderSetBindGroup(computePass, 0, m_bindGroup, 1, &m_frameUniformOffset);
+	wgpuComputePassEncoderSetBindGroup(computePass, 1, m_cullBindGroup, 0, nullptr);
+
+	// One workgroup per meshlet, spread over 2 dimensions past the default
+	// limit of workgroups per dimension
+	const uint32_t maxWorkgroupsPerDimension = 65535;
+	uint32_t workgroupCountX = std::min(lod.meshletCount, maxWorkgroupsPerDimension);
+	uint32_t workgroupCountY = (lod.meshletCount + workgroupCountX - 1) / workgroupCountX;
+	wgpuComputePassEncoderDispatchWorkgroups(computePass, workgroupCountX, workgroupCountY, 1);
+
+	wgpuComputePassEncoderEnd(computePass);
+	wgpuComputePassEncoderRelease(computePass);
+}
+
+void Application::UpdateTransforms(float time)
+{
+	m_uniforms->reset();
+	MyUniforms uniforms;
+	uniforms.projection = m_camera.projection();
+	// The dequantization depends on the bounds of the current mesh
+	uniforms.positionScale = m_vertexLayout.positionScale;
+	uniforms.positionBias = m_vertexLayout.positionBias;
+	m_frameUniformOffset = m_uniforms->allocate(uniforms);
+	m_uniforms->upload();
+
+	// Copies outside of the view are left out of the instances, and the
+	// others are grouped by level of detail, so that each level is a single
+	// instanced draw
+	const MeshLod& base = m_lods.front();
+	std::vector<std::pair<size_t, Instance>> visible;
+	visible.reserve(m_objects.size());
+	// The copies are laid out on a square grid of the XY plane, centered on
+	// the origin, so that they are at different distances from the camera and
+	// some of them are out of the view
+	const size_t columns = static_cast<size_t>(std::ceil(std::sqrt(static_cast<double>(m_objects.size()))));
+	const size_t rows = (m_objects.size() + columns - 1) / columns;
+	for (size_t i = 0; i < m_objects.size(); ++i) {
+		SceneObject& object = m_objects[i];
+		const float x = (static_cast<float>(i % columns) - 0.5f * static_cast<float>(columns - 1)) * ObjectSpacing;
+		const float y = (static_cast<float>(i / columns) - 0.5f * static_cast<float>(rows - 1)) * ObjectSpacing;
+		// Each one turns around the center of its cell, out of phase with the
+		// others
+		const float phase = 2.0f * Pi * static_cast<float>(i) / static_cast<float>(m_objects.size());
+		object.model = Mat4::translation(x, y, 0.0f) * Mat4::rotationZ(-time - phase) * Mat4::translation(0.5f, 0.0f, 0.0f) * Mat4::scale(ModelScale);
+		const Mat4 modelView = m_camera.view() * object.model;
+
+		// Without bounds, every copy is drawn
+		if (base.radius > 0.0f && !m_camera.isSphereVisible(modelView.transformPoint(base.center), base.radius * ModelScale)) {
+			continue;
+		}
+		visible.push_back({ SelectLod(modelView), Instance{ m_camera.projection() * modelView, modelView, object.color } });
+	}
+	std::stable_sort(visible.begin(), visible.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+
+	m_batches.clear();
+	for (size_t i = 0; i < visible.size(); ++i) {
+		const auto& [lod, instance] = visible[i];
+		if (m_batches.empty() || m_batches.back().lod != lod) {
+			m_batches.push_back({ lod, static_cast<uint32_t>(i), 0 });
+		}
+		++m_batches.back().instanceCount;
+		m_instanceBuffer->write(i * sizeof(Instance), &instance, sizeof(Instance));
+	}
+	m_instanceBuffer->flush();
+}
+
+size_t Application::SelectLod(const Mat4& modelView) const
+{
+	// Distance from the camera to the closest point of the bounding sphere,
+	// along the view axis
+	const MeshLod& base = m_lods.front();
+	std::array<float, 3> center = modelView.transformPoint(base.center);
+	float distance = center[2] - base.radius * ModelScale;
+
+	// Errors are in model units
+	float pixelsPerUnit = m_camera.pixelsPerUnit() * ModelScale;
+	return MeshSimplifier::selectLod(m_lods.data(), m_lods.size(), distance, pixelsPerUnit, m_lodErrorThreshold);
+}
+
 void Application::MainLoop()
 {
 	glfwPollEvents();
 	wgpuInstanceProcessEvents(m_instance);
 
-	float time = static_cast<float>(glfwGetTime());
-	// Only update the 1-st float of the buffer
-	wgpuQueueWriteBuffer(m_queue, m_uniformBuffer, offsetof(MyUniforms, time), &time, sizeof(time));
+	// Frame boundary: finish setting up resources loaded in the background
+	if (m_loader) {
+		m_loader->dispatchCompletions();
+	}
+	// Upload the chunks parsed since the previous frame, without waiting
+	// for the next ones
+	if (m_geometryStream && StreamGeometry(false)) {
+		FinishLoading();
+	}
+	if (m_sceneReady && m_hotReload) {
+		ProcessFileChanges();
+	}
+
+	if (m_sceneReady) {
+		UpdateTransforms(static_cast<float>(glfwGetTime()));
+	}
 
 	// Get the next target texture view
 	WGPUTextureView targetView = GetNextSurfaceView();
@@ -214,8 +695,8 @@ bool Application::SetupSurfaceConfig(const WGPUAdapter& adapter)
 {
 	WGPUSurfaceConfiguration config = WGPU_SURFACE_CONFIGURATION_INIT;
 	// Texture parameters
-	config.width = 640;
-	config.height = 480;
+	config.width = WindowWidth;
+	config.height = WindowHeight;
 	config.device = m_device;
 	WGPUSurfaceCapabilities capabilities = WGPU_SURFACE_CAPABILITIES_INIT;
 
@@ -307,171 +788,327 @@ WGPUAdapter Application::SetupAdapter()
 
 }
 
-bool Application::InitializePipeline()
+bool Application::InitializePipeline(WGPUShaderModule shaderModule)
 {
-	// In Initialize() or in a dedicated InitializePipeline()
-	WGPUShaderSourceWGSL wgslDesc = WGPU_SHADER_SOURCE_WGSL_INIT;
-	std::cout << "Creating shader module..." << std::endl;
-	WGPUShaderModule shaderModule = ResourceManager::loadShaderModule(RESOURCE_DIR "/shader.wgsl", m_device);
-	std::cout << "Shader module: " << shaderModule << std::endl;
-	if (shaderModule == nullptr) return false;
-
-
-	WGPURenderPipelineDescriptor pipelineDesc = WGPU_RENDER_PIPELINE_DESCRIPTOR_INIT;
-	// Vertex fetch
-	WGPUVertexBufferLayout vertexBufferLayout = WGPU_VERTEX_BUFFER_LAYOUT_INIT;
-	// We now have 2 attributes
-	std::vector<WGPUVertexAttribute> vertexAttribs(2);
-
-	// Describe the position attribute
-	vertexAttribs[0].shaderLocation = 0; // @location(0)
-	vertexAttribs[0].format = WGPUVertexFormat_Float32x3;
-	vertexAttribs[0].offset = 0;
-	// Describe the color attribute
-	vertexAttribs[1].shaderLocation = 1; // @location(1)
-	vertexAttribs[1].format = WGPUVertexFormat_Float32x3; // different type!
-	vertexAttribs[1].offset = 3 * sizeof(float); // non null offset!
-
-	vertexBufferLayout.attributeCount = static_cast<uint32_t>(vertexAttribs.size());
-	vertexBufferLayout.attributes = vertexAttribs.data();
-
-	vertexBufferLayout.arrayStride = 6 * sizeof(float);
-	//                               ^^^^^^^^^^^^^^^^^ The new stride
-	vertexBufferLayout.stepMode = WGPUVertexStepMode_Vertex;
-
-	// When describing the render pipeline:
-	pipelineDesc.vertex.bufferCount = 1;
-	pipelineDesc.vertex.buffers = &vertexBufferLayout;
-	pipelineDesc.vertex.module = shaderModule;
-
-	pipelineDesc.vertex.entryPoint = toWgpuStringView("vs_main");
-	// depth stencil
-	WGPUDepthStencilState depthStencilState = WGPU_DEPTH_STENCIL_STATE_INIT;
-	pipelineDesc.depthStencil = &depthStencilState;
-	depthStencilState.depthCompare = WGPUCompareFunction_Less;
-	depthStencilState.depthWriteEnabled = WGPUOptionalBool_True;
-	depthStencilState.format = m_depthTextureFormat;
-
-	WGPUFragmentState fragmentState = WGPU_FRAGMENT_STATE_INIT;
-	fragmentState.module = shaderModule;
-	fragmentState.entryPoint = toWgpuStringView("fs_main");
-	WGPUColorTargetState colorTarget = WGPU_COLOR_TARGET_STATE_INIT;
-	colorTarget.format = m_surfaceFormat;
-	WGPUBlendState blendState = WGPU_BLEND_STATE_INIT;
-	colorTarget.blend = &blendState;
-	fragmentState.targetCount = 1;
-	fragmentState.targets = &colorTarget;
-	pipelineDesc.fragment = &fragmentState;
-
-
-	// Define binding layout
-	WGPUBindGroupLayoutEntry bindingLayout = WGPU_BIND_GROUP_LAYOUT_ENTRY_INIT;
-	// The binding index as used in the @binding attribute in the shader
-	bindingLayout.binding = 0;
-	bindingLayout.visibility = WGPUShaderStage_Vertex | WGPUShaderStage_Fragment;
-	bindingLayout.buffer.type = WGPUBufferBindingType_Uniform;
-	bindingLayout.buffer.minBindingSize = sizeof(MyUniforms);
-
-	// Create a bind group layout
-	WGPUBindGroupLayoutDescriptor bindGroupLayoutDesc = WGPU_BIND_GROUP_LAYOUT_DESCRIPTOR_INIT;
-	bindGroupLayoutDesc.nextInChain = nullptr;
-	bindGroupLayoutDesc.entryCount = 1;
-	bindGroupLayoutDesc.entries = &bindingLayout;
-	m_bindGroupLayout = wgpuDeviceCreateBindGroupLayout(m_device, &bindGroupLayoutDesc);
+	// Layouts are generated from the declarations of the shader
+	const ShaderReflection* reflection = m_shaderModules->reflection(shaderModule);
+	if (reflection == nullptr) return false;
+	const ShaderReflection::Binding* uniforms = reflection->findBinding(0, 0);
+	if (uniforms == nullptr || uniforms->layout.buffer.minBindingSize != sizeof(MyUniforms)) {
+		std::cerr << "MyUniforms does not match the uniforms of " << ShaderPath << "!" << std::endl;
+		return false;
+	}
+	const ShaderReflection::Binding* instances = reflection->findBinding(0, 1);
+	if (instances == nullptr || instances->layout.buffer.minBindingSize != sizeof(Instance)) {
+		std::cerr << "Instance does not match the instances of " << ShaderPath << "!" << std::endl;
+		return false;
+	}
+	m_bindGroupLayout = m_layouts->bindGroupLayout(*reflection, 0);
+	m_layout = m_layouts->pipelineLayout(*reflection, RenderEntryPoints);
+
+	// The culling pass is only in variants with MESHLET_CULLING, which is
+	// enabled even when the mesh has no meshlets, in case a reloaded one
+	// brings some
+	if (reflection->findEntryPoint(CullEntryPoint) != nullptr) {
+		m_cullBindGroupLayout = m_layouts->bindGroupLayout(*reflection, 1);
+		m_cullLayout = m_layouts->pipelineLayout(*reflection, { CullEntryPoint });
+	}
 
-	// Create the pipeline layout
-	WGPUPipelineLayoutDescriptor layoutDesc = WGPU_PIPELINE_LAYOUT_DESCRIPTOR_INIT;
-	layoutDesc.nextInChain = nullptr;
-	layoutDesc.bindGroupLayoutCount = 1;
-	layoutDesc.bindGroupLayouts = &m_bindGroupLayout;
-	m_layout = wgpuDeviceCreatePipelineLayout(m_device, &layoutDesc);
+	// Frames are drawn without the mesh until it is compiled
+	RequestRenderPipeline(shaderModule);
+	if (m_meshletCount > 0) {
+		m_cullPipeline = CreateCullingPipeline(shaderModule);
+		if (m_cullPipeline == nullptr) return false;
+	}
+	return true;
+}
 
-	pipelineDesc.layout = m_layout;
+std::vector<PipelineConstant> Application::ShaderConstants() const
+{
+	// By override name, each stage only gets those it uses
+	return {
+		{ "quantizedPositions", m_vertexLayout.positionFormat != WGPUVertexFormat_Float32x3 ? 1.0 : 0.0 },
+		{ "near", m_camera.nearPlane() },
+		{ "far", m_camera.farPlane() },
+		{ "sourceIndexUint16", m_indexFormat == WGPUIndexFormat_Uint16 ? 1.0 : 0.0 },
+		{ "coneCulling", m_backFaceCulling ? 1.0 : 0.0 },
+	};
+}
 
+void Application::RequestRenderPipeline(WGPUShaderModule shaderModule)
+{
+	// Vertex fetch: position and color, in whichever format the geometry was
+	// encoded with (see VertexLayout and VertexQuantizer)
+	std::array<WGPUVertexAttribute, 2> vertexAttribs;
+	const WGPUVertexBufferLayout vertexBufferLayout = m_vertexLayout.bufferLayout(vertexAttribs);
+	const ShaderReflection* reflection = m_shaderModules->reflection(shaderModule);
+	if (reflection == nullptr || !reflection->checkVertexInputs("vs_main", 1, &vertexBufferLayout)) return;
+
+	RenderPipelineState state;
+	state.label = "Render";
+	state.shaderModule = shaderModule;
+	// Specialized for the geometry and camera, with no uniform loads or
+	// branches left for these in the compiled stages
+	const std::vector<PipelineConstant> constants = ShaderConstants();
+	if (!reflection->stageConstants(state.vertexEntryPoint, constants, state.vertexConstants)) return;
+	if (!reflection->stageConstants(state.fragmentEntryPoint, constants, state.fragmentConstants)) return;
+	state.layout = m_layout;
+	state.vertexLayout = m_vertexLayout;
+	state.colorFormat = m_surfaceFormat;
+	state.blendEnabled = true;
+	state.blend = WGPU_BLEND_STATE_INIT;
+	state.depthFormat = m_depthTextureFormat;
+	state.depthCompare = WGPUCompareFunction_Less;
+	state.depthWriteEnabled = true;
+
+	if (m_backFaceCulling) {
+		// The view space of vs_main looks towards +Z with Y up, which flips
+		// the winding: triangles that are counter-clockwise around their
+		// normal appear clockwise on screen when facing the camera.
+		state.frontFace = WGPUFrontFace_CW;
+		state.cullMode = WGPUCullMode_Back;
+	}
 
-	m_pipeline = wgpuDeviceCreateRenderPipeline(m_device, &pipelineDesc);
-	wgpuShaderModuleRelease(shaderModule);
+	// Compiled in the background, so that a new pipeline never stalls a
+	// frame. Requests may complete out of order.
+	const uint32_t request = ++m_pipelineRequest;
+	m_pipelines->acquireAsync(state, [this, request](WGPURenderPipeline pipeline) {
+		if (request != m_pipelineRequest) {
+			if (pipeline) m_pipelines->release(pipeline);
+			return;
+		}
+		// On error, keep drawing with the current pipeline if there is one
+		if (pipeline == nullptr) return;
+		if (m_pipeline) m_pipelines->release(m_pipeline);
+		m_pipeline = pipeline;
+	});
+}
 
+WGPUComputePipeline Application::CreateCullingPipeline(WGPUShaderModule shaderModule)
+{
+	const ShaderReflection* reflection = m_shaderModules->reflection(shaderModule);
+	std::vector<PipelineConstant> stageConstants;
+	if (reflection == nullptr || !reflection->stageConstants(CullEntryPoint, ShaderConstants(), stageConstants)) return nullptr;
+	std::vector<WGPUConstantEntry> constants(stageConstants.size(), WGPU_CONSTANT_ENTRY_INIT);
+	for (size_t i = 0; i < constants.size(); ++i) {
+		constants[i].key = toWgpuStringView(stageConstants[i].key);
+		constants[i].value = stageConstants[i].value;
+	}
 
+	WGPUComputePipelineDescriptor computePipelineDesc = WGPU_COMPUTE_PIPELINE_DESCRIPTOR_INIT;
+	computePipelineDesc.label = toWgpuStringView("Meshlet culling");
+	computePipelineDesc.layout = m_cullLayout;
+	computePipelineDesc.compute.module = shaderModule;
+	computePipelineDesc.compute.entryPoint = toWgpuStringView(CullEntryPoint);
+	computePipelineDesc.compute.constantCount = constants.size();
+	computePipelineDesc.compute.constants = constants.data();
+	return wgpuDeviceCreateComputePipeline(m_device, &computePipelineDesc);
+}
 
+bool Application::InitializeBuffers()
+{
+	// Preferred path: map the binary mesh cache and upload straight from it.
+	// Otherwise processed or packed geometry is loaded at once, which also
+	// writes the cache, and anything else is streamed from the text file.
+	GeometrySource source;
+	if (!ResourceManager::openGeometry(GeometryPath, source, GeometryDimensions, m_geometryProcessing)) return false;
+	if (source.streamer) {
+		BeginGeometryStream(std::move(source.streamer), source.cacheKey);
+		while (!StreamGeometry(true)) {}
+	}
+	else {
+		UploadGeometry(source.geometry);
+	}
+	// It is not easy with the auto-generation of code to remove the previously
+	// defined `vertexBuffer` attribute, but at the same time some compilers
+	// (rightfully) complain if we do not use it. This is a hack to mark the
+	// variable as used and have automated build tests pass.
+	(void)m_vertexBuffer;
+	(void)m_vertexCount;
+	return true;
+}
 
+void Application::InitializeUniforms()
+{
+	// Uniforms are written on each frame, see UpdateTransforms()
+	m_objects.assign(std::max<size_t>(m_objectCount, 1), SceneObject{ Mat4(), ObjectColor });
+	m_uniforms = std::make_unique<UniformArena>(m_device, m_queue, sizeof(MyUniforms), 1);
 
+	// Large enough for every copy to be visible
+	m_instanceBuffer = std::make_unique<ShadowBuffer>(m_device, m_queue, m_objects.size() * sizeof(Instance), WGPUBufferUsage_Storage, "Instances");
+}
 
+void Application::UploadGeometry(const Geometry& geometry)
+{
+	m_indexCount = static_cast<uint32_t>(geometry.indexCount());
+	m_indexFormat = geometry.indexFormat();
+	m_vertexLayout = geometry.vertexLayout();
+	m_bounds = geometry.bounds();
+	m_meshletCount = static_cast<uint32_t>(geometry.meshletCount());
+	m_lods.assign(geometry.lodData(), geometry.lodData() + geometry.lodCount());
+	CreateGeometryBuffers(geometry.vertexDataSize(), geometry.indexDataSize());
+	wgpuQueueWriteBuffer(m_queue, m_pointBuffer, 0, geometry.vertexData(), geometry.vertexDataSize());
+	wgpuQueueWriteBuffer(m_queue, m_indexBuffer, 0, geometry.indexData(), geometry.indexDataSize());
+	if (m_meshletCount > 0) {
+		CreateCullingBuffers(geometry);
+	}
+}
 
+void Application::BeginGeometryStream(std::unique_ptr<GeometryStreamer> streamer, const MeshCache::Key& cacheKey)
+{
+	// Chunks are parsed on a worker thread through a bounded ring of staging
+	// slots, and uploaded by StreamGeometry() as soon as they are ready
+	m_geometryStream = std::move(streamer);
+	m_indexCount = static_cast<uint32_t>(m_geometryStream->indexCount());
+	m_indexFormat = m_geometryStream->indexFormat();
+	m_vertexLayout = m_geometryStream->vertexLayout();
+	m_bounds = MeshBounds();
+	m_meshletCount = 0;
+	m_lods.clear();
+	CreateGeometryBuffers(m_geometryStream->pointDataSize(), m_geometryStream->indexDataSize());
+
+	m_writesGeometryCache = m_geometryCacheWriter.open(
+		cacheKey,
+		m_geometryStream->pointDataSize() / m_vertexLayout.stride, m_vertexLayout,
+		m_geometryStream->indexCount(), m_indexFormat
+	);
+	m_geometryStream->start();
+}
 
+bool Application::StreamGeometry(bool wait)
+{
+	if (!m_geometryStream->poll([this](const GeometryStreamer::Batch& batch) { UploadGeometryBatch(batch); }, wait)) {
+		return false;
+	}
+	if (m_writesGeometryCache) {
+		m_geometryCacheWriter.setBounds(m_bounds);
+		if (!m_geometryCacheWriter.close()) {
+			std::cerr << "Could not write mesh cache for " << GeometryPath << std::endl;
+		}
+		m_writesGeometryCache = false;
+	}
+	m_geometryStream.reset();
 	return true;
 }
 
-bool Application::InitializeBuffers()
+void Application::UploadGeometryBatch(const GeometryStreamer::Batch& batch)
 {
-	std::vector<float> pointData;
-	std::vector<uint16_t> indexData;
-
-	// 1. Load from disk into CPU-side vectors pointData and indexData
-	bool success = ResourceManager::loadGeometry(RESOURCE_DIR "/pyramid.txt", pointData, indexData, 3);
-	if (!success) return false;
-
-	m_indexCount = static_cast<uint32_t>(indexData.size());
+	m_bounds.merge(batch.bounds);
+	if (batch.pointCount > 0) {
+		wgpuQueueWriteBuffer(m_queue, m_pointBuffer, batch.pointOffset, batch.pointData, batch.pointDataSize());
+	}
+	if (batch.indexCount > 0) {
+		wgpuQueueWriteBuffer(m_queue, m_indexBuffer, batch.indexOffset, batch.indexData, batch.indexDataSize());
+	}
+	if (m_writesGeometryCache) {
+		m_geometryCacheWriter.writeVertices(batch.pointOffset, batch.pointData, batch.pointDataSize());
+		m_geometryCacheWriter.writeIndices(batch.indexOffset, batch.indexData, batch.indexCount * Geometry::indexSize(batch.indexFormat));
+	}
+}
 
-	// 2. Create GPU buffers and upload data to them
+void Application::CreateGeometryBuffers(uint64_t vertexDataSize, uint64_t indexDataSize)
+{
 	WGPUBufferDescriptor bufferDesc = WGPU_BUFFER_DESCRIPTOR_INIT;
-	bufferDesc.size = pointData.size() * sizeof(float);
+	bufferDesc.size = vertexDataSize;
 	bufferDesc.usage = WGPUBufferUsage_CopyDst | WGPUBufferUsage_Vertex;
 	m_pointBuffer = wgpuDeviceCreateBuffer(m_device, &bufferDesc);
 
-	wgpuQueueWriteBuffer(m_queue, m_pointBuffer, 0, pointData.data(), bufferDesc.size);
-	// It is not easy with the auto-generation of code to remove the previously
-	// defined `vertexBuffer` attribute, but at the same time some compilers
-	// (rightfully) complain if we do not use it. This is a hack to mark the
-	// variable as used and have automated build tests pass.
-	(void)m_vertexBuffer;
-	(void)m_vertexCount;
-
-	bufferDesc.size = indexData.size() * sizeof(uint16_t);
-	bufferDesc.size = (bufferDesc.size + 3) & ~3; // round up to the next multiple of 4
-	indexData.resize((indexData.size() + 1) & ~1); // round up to the next multiple of 2
-	bufferDesc.usage = WGPUBufferUsage_CopyDst | WGPUBufferUsage_Index;;
+	// The index data size is already rounded up to a multiple of 4
+	bufferDesc.size = indexDataSize;
+	bufferDesc.usage = WGPUBufferUsage_CopyDst | WGPUBufferUsage_Index;
+	if (m_meshletCount > 0) {
+		// Read by the culling pass
+		bufferDesc.usage |= WGPUBufferUsage_Storage;
+	}
 	m_indexBuffer = wgpuDeviceCreateBuffer(m_device, &bufferDesc);
+}
 
-
-	wgpuQueueWriteBuffer(m_queue, m_indexBuffer, 0, indexData.data(), bufferDesc.size);
-
-
-	// 3. Create and fill uniform buffer
-	// Create uniform buffer (reusing bufferDesc from other buffer creations)
-	// The buffer will only contain 1 float with the value of uTime
-	// then 3 floats left empty but needed by alignment constraints
-	bufferDesc.size = sizeof(MyUniforms);
+void Application::CreateCullingBuffers(const Geometry& geometry)
+{
+	WGPUBufferDescriptor bufferDesc = WGPU_BUFFER_DESCRIPTOR_INIT;
+	bufferDesc.label = toWgpuStringView("Meshlets");
+	bufferDesc.size = geometry.meshletDataSize();
+	bufferDesc.usage = WGPUBufferUsage_CopyDst | WGPUBufferUsage_Storage;
+	m_meshletBuffer = wgpuDeviceCreateBuffer(m_device, &bufferDesc);
+	wgpuQueueWriteBuffer(m_queue, m_meshletBuffer, 0, geometry.meshletData(), geometry.meshletDataSize());
+
+	// Large enough for all meshlets of the base mesh to be visible. Culled
+	// indices are always 32-bit, as 16-bit values cannot be written
+	// atomically one at a time.
+	uint64_t maxIndexCount = geometry.lodCount() > 0 ? geometry.lodData()[0].indexCount : geometry.indexCount();
+	bufferDesc.label = toWgpuStringView("Culled indices");
+	bufferDesc.size = std::max<uint64_t>(maxIndexCount, 1) * sizeof(uint32_t);
+	bufferDesc.usage = WGPUBufferUsage_Storage | WGPUBufferUsage_Index;
+	m_culledIndexBuffer = wgpuDeviceCreateBuffer(m_device, &bufferDesc);
+
+	bufferDesc.label = toWgpuStringView("Draw arguments");
+	bufferDesc.size = 5 * sizeof(uint32_t);
+	bufferDesc.usage = WGPUBufferUsage_CopyDst | WGPUBufferUsage_Storage | WGPUBufferUsage_Indirect;
+	m_drawArgsBuffer = wgpuDeviceCreateBuffer(m_device, &bufferDesc);
+
+	// Range of meshlets to cull, see CullParams in culling.wgsl
+	bufferDesc.label = toWgpuStringView("Cull parameters");
+	bufferDesc.size = 4 * sizeof(uint32_t);
 	bufferDesc.usage = WGPUBufferUsage_CopyDst | WGPUBufferUsage_Uniform;
-	m_uniformBuffer = wgpuDeviceCreateBuffer(m_device, &bufferDesc);
-	MyUniforms uniforms;
-	uniforms.time = 1.0f;
-	uniforms.color = { 0.0f, 1.0f, 0.4f, 1.0f };
-	wgpuQueueWriteBuffer(m_queue, m_uniformBuffer, 0, &uniforms, sizeof(uniforms));
+	m_cullParamsBuffer = wgpuDeviceCreateBuffer(m_device, &bufferDesc);
+}
 
-	return true;
+void Application::ReleaseGeometryBuffers()
+{
+	for (WGPUBuffer buffer : { m_pointBuffer, m_indexBuffer, m_meshletBuffer, m_culledIndexBuffer, m_drawArgsBuffer, m_cullParamsBuffer }) {
+		if (buffer == nullptr) continue;
+		// Along with the bind groups that use it, i.e. the culling one
+		if (m_bindGroups) m_bindGroups->evict(buffer);
+		wgpuBufferRelease(buffer);
+	}
+	m_pointBuffer = nullptr;
+	m_indexBuffer = nullptr;
+	m_meshletBuffer = nullptr;
+	m_culledIndexBuffer = nullptr;
+	m_drawArgsBuffer = nullptr;
+	m_cullParamsBuffer = nullptr;
+	m_cullBindGroup = nullptr;
 }
+
 void Application::InitializeBindGroups()
 {
-	// Create a binding
-	WGPUBindGroupEntry binding = WGPU_BIND_GROUP_ENTRY_INIT;
+	// Create the bindings
+	std::vector<WGPUBindGroupEntry> bindings(2, WGPU_BIND_GROUP_ENTRY_INIT);
 
 	// The index of the binding (the entries in bindGroupDesc can be in any order)
-	binding.binding = 0;
+	bindings[0].binding = 0;
 	// The buffer it is actually bound to
-	binding.buffer = m_uniformBuffer;
-	// We can specify an offset within the buffer, so that a single buffer can hold
-	// multiple uniform blocks.
-	binding.offset = 0;
-	// And we specify again the size of the buffer.
-	binding.size = sizeof(MyUniforms);
-
-	// A bind group contains one or multiple bindings
-	WGPUBindGroupDescriptor bindGroupDesc = WGPU_BIND_GROUP_DESCRIPTOR_INIT;
-	bindGroupDesc.layout = m_bindGroupLayout;
-	// There must be as many bindings as declared in the layout!
-	bindGroupDesc.entryCount = 1;
-	bindGroupDesc.entries = &binding;
-	m_bindGroup = wgpuDeviceCreateBindGroup(m_device, &bindGroupDesc);
+	bindings[0].buffer = m_uniforms->buffer();
+	// The uniforms of a frame are a block of the buffer, selected with a
+	// dynamic offset when the bind group is set
+	bindings[0].offset = 0;
+	// And we specify again the size of one block.
+	bindings[0].size = sizeof(MyUniforms);
+
+	// The instances of every draw, which start at their firstInstance
+	bindings[1].binding = 1;
+	bindings[1].buffer = m_instanceBuffer->buffer();
+	bindings[1].offset = 0;
+	bindings[1].size = m_instanceBuffer->size();
+
+	// A bind group contains one or multiple bindings, as many as declared
+	// in the layout. Shared with any other user of the same resources.
+	m_bindGroup = m_bindGroups->bindGroup(m_bindGroupLayout, bindings);
+
+	if (m_meshletCount > 0) {
+		CreateCullBindGroup();
+	}
 }
 
+void Application::CreateCullBindGroup()
+{
+	const WGPUBuffer cullBuffers[5] = { m_meshletBuffer, m_indexBuffer, m_culledIndexBuffer, m_drawArgsBuffer, m_cullParamsBuffer };
+	std::vector<WGPUBindGroupEntry> cullBindings(5, WGPU_BIND_GROUP_ENTRY_INIT);
+	for (uint32_t i = 0; i < cullBindings.size(); ++i) {
+		cullBindings[i].binding = i;
+		cullBindings[i].buffer = cullBuffers[i];
+		cullBindings[i].offset = 0;
+		cullBindings[i].size = wgpuBufferGetSize(cullBuffers[i]);
+	}
+	m_cullBindGroup = m_bindGroups->bindGroup(m_cullBindGroupLayout, cullBindings);
+}
@@ -1,5 +1,20 @@
 #include <webgpu/webgpu.h>
 #include <array>
+#include <memory>
+#include <string>
+#include <vector>
+#include "BindGroupCache.h"
+#include "Camera.h"
+#include "FileWatcher.h"
+#include "Geometry.h"
+#include "GeometryStreamer.h"
+#include "MeshCache.h"
+#include "PipelineLayoutCache.h"
+#include "RenderPipelineCache.h"
+#include "ResourceLoader.h"
+#include "ShaderModuleCache.h"
+#include "ShadowBuffer.h"
+#include "UniformArena.h"
 struct GLFWwindow;
 
 class Application
@@ -8,6 +23,15 @@ public:
     // Initialize everything and return true if it went all right
     bool Initialize();
 
+    // Opt into post-load processing of the geometry, before Initialize().
+    // Unprocessed geometry is streamed from the text file on a cache miss,
+    // processing needs the whole mesh in memory at once.
+    void SetGeometryProcessing(GeometryProcessing processing) { m_geometryProcessing = processing; }
+
+    // Number of copies of the mesh to draw, before Initialize(). Meshlet
+    // culling is only used with a single copy.
+    void SetObjectCount(size_t count) { m_objectCount = count; }
+
     // Uninitialize everything that was initialized
     void Terminate();
 
@@ -23,21 +47,88 @@ public:
 private:
     WGPUTextureView GetNextSurfaceView();
     void RenderPassEncoder(const WGPUTextureView& targetView);
+    void DrawScene(WGPURenderPassEncoder renderPass);
+    void CullingPassEncoder(WGPUCommandEncoder encoder);
+    void UpdateTransforms(float time);
+    size_t SelectLod(const Mat4& modelView) const;
+    bool CullsMeshlets() const;
     void SetupDevice(const WGPUAdapter& adapter);
     WGPUAdapter SetupAdapter();
-    bool InitializePipeline();
+    void StartLoading();
+    void OnResourceLoaded();
+    void FinishLoading();
+    bool InitializeScene(WGPUShaderModule shaderModule);
+    void InitializeLods();
+    bool InitializePipeline(WGPUShaderModule shaderModule);
+    std::vector<PipelineConstant> ShaderConstants() const;
+    void RequestRenderPipeline(WGPUShaderModule shaderModule);
+    WGPUComputePipeline CreateCullingPipeline(WGPUShaderModule shaderModule);
     bool InitializeBuffers();
+    void UploadGeometry(const Geometry& geometry);
+    void BeginGeometryStream(std::unique_ptr<GeometryStreamer> streamer, const MeshCache::Key& cacheKey);
+    bool StreamGeometry(bool wait);
+    void UploadGeometryBatch(const GeometryStreamer::Batch& batch);
+    void InitializeUniforms();
+    void CreateGeometryBuffers(uint64_t vertexDataSize, uint64_t indexDataSize);
+    void CreateCullingBuffers(const Geometry& geometry);
+    void ReleaseGeometryBuffers();
     void InitializeBindGroups();
+    void CreateCullBindGroup();
+    void WatchShaderFiles(const PreprocessedShader& shader);
+    void ProcessFileChanges();
+    void ReloadShader(const PreprocessedShader& shader);
+    bool UsesCurrentLayouts(WGPUShaderModule shaderModule);
+    void ReloadGeometry(const Geometry& geometry);
 
 private:
     GLFWwindow* m_window = nullptr;
 
+    // Load the scene on background threads rather than in Initialize()
+    bool m_asyncLoading = true;
+    std::unique_ptr<ResourceLoader> m_loader;
+    PreprocessedShaderHandle m_shaderHandle;
+    GeometrySourceHandle m_geometryHandle;
+    // Geometry missing from the mesh cache, uploaded chunk by chunk at frame
+    // boundaries and written through to the cache for the next launch
+    std::unique_ptr<GeometryStreamer> m_geometryStream;
+    MeshCache::Writer m_geometryCacheWriter;
+    bool m_writesGeometryCache = false;
+    // Whether buffers, pipelines and bind groups are all set up
+    bool m_sceneReady = false;
+
+    // Whether resources are read from a pack rather than loose files
+    bool m_usesResourcePack = false;
+
+    // Rebuild the shader and the geometry when they change on disk
+    bool m_hotReload = true;
+    FileWatcher m_fileWatcher;
+    // Shader modules shared by content, so that reloading an unchanged
+    // shader or creating variants of one does not compile it again
+    std::unique_ptr<ShaderModuleCache> m_shaderModules;
+    // Acquired from m_shaderModules, kept to rebuild the pipelines when
+    // reloaded geometry changes encoding
+    WGPUShaderModule m_shaderModule = nullptr;
+    // Render pipelines shared by state, so that rebuilding them after a
+    // reload only compiles what actually changed
+    std::unique_ptr<RenderPipelineCache> m_pipelines;
+    // Layouts generated from the reflected shader, owned by the cache
+    std::unique_ptr<PipelineLayoutCache> m_layouts;
+    // Bind groups shared by layout and resources, owned by the cache.
+    // Buffers are evicted from it before they are released.
+    std::unique_ptr<BindGroupCache> m_bindGroups;
+    // Incremented on each geometry reload
+    uint32_t m_geometryGeneration = 0;
+
     WGPUInstance m_instance = nullptr;
     WGPUDevice m_device = nullptr;
     WGPUQueue m_queue = nullptr;
 
     WGPUSurface m_surface = nullptr;
+    // Acquired from m_pipelines, null until it is first compiled
     WGPURenderPipeline m_pipeline = nullptr;
+    // Incremented on each RequestRenderPipeline(), only the latest request
+    // replaces m_pipeline
+    uint32_t m_pipelineRequest = 0;
     WGPUTextureFormat m_surfaceFormat = WGPUTextureFormat_Undefined;
 
     WGPUBuffer m_vertexBuffer = nullptr;
@@ -46,11 +137,80 @@ private:
     WGPUBuffer m_pointBuffer = nullptr;
     WGPUBuffer m_indexBuffer = nullptr;
     uint32_t m_indexCount = 0;
+    WGPUIndexFormat m_indexFormat = WGPUIndexFormat_Uint16;
+    // Post-load processing of the geometry, baked into the mesh cache
+    GeometryProcessing m_geometryProcessing = GeometryProcessing_None;
+    // Levels of detail of the mesh, at least the base mesh, and the one
+    // drawn this frame
+    std::vector<MeshLod> m_lods;
+    // Largest simplification error allowed on screen, in pixels
+    float m_lodErrorThreshold = 1.0f;
+    // Encoding of the vertices in m_pointBuffer
+    VertexLayout m_vertexLayout;
+    // Extent of the mesh in model space, computed while loading it
+    MeshBounds m_bounds;
+
+    // Its matrices are uploaded with the model transform on each frame
+    Camera m_camera;
+
+    // A copy of the mesh, drawn as an instance
+    struct SceneObject
+    {
+        Mat4 model;
+        std::array<float, 4> color;
+    };
+    // Number of copies of the mesh, laid out on a grid
+    size_t m_objectCount = 1;
+    std::vector<SceneObject> m_objects;
+    // Visible copies that use the same level of detail, drawn at once
+    struct InstanceBatch
+    {
+        size_t lod;
+        uint32_t firstInstance;
+        uint32_t instanceCount;
+    };
+    // Rebuilt on each frame, sorted by level of detail
+    std::vector<InstanceBatch> m_batches;
+
+    // GPU cluster culling, used when the geometry has meshlets: a compute
+    // pass writes the indices of visible meshlets to m_culledIndexBuffer and
+    // the draw arguments to m_drawArgsBuffer.
+    uint32_t m_meshletCount = 0;
+    WGPUBuffer m_meshletBuffer = nullptr;
+    WGPUBuffer m_culledIndexBuffer = nullptr;
+    WGPUBuffer m_drawArgsBuffer = nullptr;
+    WGPUBuffer m_cullParamsBuffer = nullptr;
+    WGPUComputePipeline m_cullPipeline = nullptr;
+    // From m_layouts, null when the shader has no culling pass
+    WGPUPipelineLayout m_cullLayout = nullptr;
+    WGPUBindGroupLayout m_cullBindGroupLayout = nullptr;
+    // From m_bindGroups
+    WGPUBindGroup m_cullBindGroup = nullptr;
+    // Cull back faces when rasterizing, which also enables meshlet normal
+    // cone culling. Only correct for meshes with a consistent winding.
+    bool m_backFaceCulling = false;
+
+    // Uniforms rewritten on each frame, bound with a dynamic offset. The
+    // MyUniforms of the frame are at m_frameUniformOffset.
+    std::unique_ptr<UniformArena> m_uniforms;
+    uint32_t m_frameUniformOffset = UniformArena::InvalidOffset;
+    // Element of the instances storage buffer of shader.wgsl
+    struct Instance
+    {
+        // Model to clip space and model to view space
+        Mat4 modelViewProjection;
+        Mat4 modelView;
+        std::array<float, 4> color;
+    };
+    static_assert(sizeof(Instance) % 16 == 0);
+    // An Instance per visible copy of the mesh, written on each frame in
+    // the order of m_batches. Only the instances that moved are uploaded.
+    std::unique_ptr<ShadowBuffer> m_instanceBuffer;
 
-    WGPUBuffer m_uniformBuffer = nullptr;
-
+    // From m_layouts. Group 0 is shared with the culling pipeline.
     WGPUPipelineLayout m_layout = nullptr;
     WGPUBindGroupLayout m_bindGroupLayout = nullptr;
+    // From m_bindGroups
     WGPUBindGroup m_bindGroup = nullptr;
 
     WGPUTextureFormat m_depthTextureFormat = WGPUTextureFormat_Depth24Plus;
@@ -58,13 +218,23 @@ private:
 
 
 private:
+    // New version of the shader, swapped in only once the device has
+    // validated it. The render pipeline follows in the background.
+    struct ShaderReload
+    {
+        uint32_t geometryGeneration;
+        WGPUShaderModule shaderModule;
+        WGPUComputePipeline cullPipeline;
+    };
+    void FinishShaderReload(const ShaderReload& reload, bool valid);
+
     struct MyUniforms
     {
-        std::array<float, 4> color;  // or float color[4]
-        float time;
-        // align on a multiple of 16, as the total size must be a multiple of the alignment size of its largest field.
-        // this padding makes it 32
-        float _pad[3];
+        // View to clip space
+        Mat4 projection;
+        // Dequantization of vertex positions: bias + scale * position
+        std::array<float, 4> positionScale;
+        std::array<float, 4> positionBias;
     };
 
     static_assert(sizeof(MyUniforms) % 16 == 0);
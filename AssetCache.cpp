@@ -0,0 +1,93 @@
+#include "AssetCache.h"
+#include "Hash.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <mutex>
+#include <string>
+#include <system_error>
+
+#ifndef ASSET_CACHE_DIR
+#  ifdef RESOURCE_DIR
+#    define ASSET_CACHE_DIR RESOURCE_DIR "/.cache"
+#  else
+#    define ASSET_CACHE_DIR ".cache"
+#  endif
+#endif
+
+namespace
+{
+	std::mutex directoryMutex;
+	std::filesystem::path directoryOverride;
+
+	std::filesystem::path environmentDirectory()
+	{
+#ifdef _WIN32
+		char* value = nullptr;
+		size_t length = 0;
+		if (_dupenv_s(&value, &length, "ASSET_CACHE_DIR") != 0 || value == nullptr) return {};
+		std::filesystem::path directory = value;
+		free(value);
+		return directory;
+#else
+		const char* value = std::getenv("ASSET_CACHE_DIR");
+		return value != nullptr ? std::filesystem::path(value) : std::filesystem::path();
+#endif
+	}
+}
+
+std::filesystem::path AssetCache::directory()
+{
+	{
+		std::lock_guard<std::mutex> lock(directoryMutex);
+		if (!directoryOverride.empty()) return directoryOverride;
+	}
+	std::filesystem::path directory = environmentDirectory();
+	return directory.empty() ? std::filesystem::path(ASSET_CACHE_DIR) : directory;
+}
+
+void AssetCache::setDirectory(const std::filesystem::path& directory)
+{
+	std::lock_guard<std::mutex> lock(directoryMutex);
+	directoryOverride = directory;
+}
+
+std::filesystem::path AssetCache::entryPath(uint64_t key, const char* kind)
+{
+	// Fan entries out over 256 subdirectories, shared caches grow large
+	std::string name = Hasher::toHex(key);
+	std::filesystem::path path = directory() / kind / name.substr(0, 2) / name;
+	path += std::string(".") + kind;
+	return path;
+}
+
+std::filesystem::path AssetCache::temporaryPath(const std::filesystem::path& entryPath)
+{
+	std::error_code ec;
+	std::filesystem::create_directories(entryPath.parent_path(), ec);
+
+	// Unique per process and per writer. The time disambiguates processes of
+	// different machines writing to a shared directory.
+	static std::atomic<uint32_t> writerCount{ 0 };
+	static const uint64_t processSalt = [] {
+		Hasher hasher;
+		hasher.updateValue(std::filesystem::file_time_type::clock::now().time_since_epoch().count());
+		hasher.updateValue(&writerCount);
+		return hasher.digest();
+	}();
+	std::filesystem::path path = entryPath;
+	path += ".tmp" + Hasher::toHex(processSalt).substr(0, 8) + "-" + std::to_string(writerCount++);
+	return path;
+}
+
+bool AssetCache::publish(const std::filesystem::path& temporaryPath, const std::filesystem::path& entryPath)
+{
+	std::error_code ec;
+	std::filesystem::rename(temporaryPath, entryPath, ec);
+	if (!ec) return true;
+
+	// Some platforms refuse to replace a file that is in use. Since entries
+	// are content-addressed, the one already there is just as good.
+	std::filesystem::remove(temporaryPath, ec);
+	return std::filesystem::exists(entryPath, ec);
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+
+/**
+ * Content-addressed store for derived data (processed meshes, ...), shared
+ * by every run and, when the directory is on a shared drive, every machine.
+ *
+ * An entry is named after a key hashing everything it is derived from: the
+ * bytes of the source file and the processing options. Entries thus never go
+ * stale, editing a source or changing an option simply yields a new key, and
+ * two processes producing the same key produce the same bytes. Entries are
+ * never modified once published.
+ */
+class AssetCache
+{
+public:
+	/**
+	 * Directory holding the entries. In order of precedence: the last call to
+	 * setDirectory(), the ASSET_CACHE_DIR environment variable, the
+	 * ASSET_CACHE_DIR build setting, and `.cache` in the resource directory.
+	 */
+	static std::filesystem::path directory();
+	static void setDirectory(const std::filesystem::path& directory);
+
+	/**
+	 * Path of entry `key` of a given kind, which is also its file extension,
+	 * e.g. <directory>/meshcache/3f/3f09c1d2a4b5e6f7.meshcache
+	 */
+	static std::filesystem::path entryPath(uint64_t key, const char* kind);
+
+	/**
+	 * Unique temporary path next to `entryPath`, whose directory is created
+	 * if needed. Entries are written there, then published.
+	 */
+	static std::filesystem::path temporaryPath(const std::filesystem::path& entryPath);
+
+	/**
+	 * Atomically move a fully written temporary file to `entryPath`. Losing
+	 * the race against another writer of the same entry is not an error.
+	 */
+	static bool publish(const std::filesystem::path& temporaryPath, const std::filesystem::path& entryPath);
+};
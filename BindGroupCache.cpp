@@ -0,0 +1,109 @@
+#include "BindGroupCache.h"
+#include "Hash.h"
+
+#include <algorithm>
+
+namespace
+{
+	bool sameEntry(const WGPUBindGroupEntry& a, const WGPUBindGroupEntry& b)
+	{
+		return a.binding == b.binding
+			&& a.buffer == b.buffer
+			&& a.offset == b.offset
+			&& a.size == b.size
+			&& a.sampler == b.sampler
+			&& a.textureView == b.textureView;
+	}
+
+	uint64_t hashBindGroup(WGPUBindGroupLayout layout, const std::vector<WGPUBindGroupEntry>& entries)
+	{
+		// Field by field, since entries have padding and a chain pointer
+		Hasher hasher;
+		hasher.updateValue(reinterpret_cast<uintptr_t>(layout));
+		for (const WGPUBindGroupEntry& entry : entries) {
+			hasher.updateValue(entry.binding);
+			hasher.updateValue(reinterpret_cast<uintptr_t>(entry.buffer));
+			hasher.updateValue(entry.offset);
+			hasher.updateValue(entry.size);
+			hasher.updateValue(reinterpret_cast<uintptr_t>(entry.sampler));
+			hasher.updateValue(reinterpret_cast<uintptr_t>(entry.textureView));
+		}
+		return hasher.digest();
+	}
+}
+
+BindGroupCache::BindGroupCache(WGPUDevice device)
+	: m_device(device)
+{}
+
+BindGroupCache::~BindGroupCache()
+{
+	for (auto& [key, entry] : m_entries) {
+		releaseEntry(entry);
+	}
+}
+
+WGPUBindGroup BindGroupCache::bindGroup(WGPUBindGroupLayout layout, const std::vector<WGPUBindGroupEntry>& entries)
+{
+	std::vector<WGPUBindGroupEntry> sorted = entries;
+	std::sort(sorted.begin(), sorted.end(), [](const WGPUBindGroupEntry& a, const WGPUBindGroupEntry& b) {
+		return a.binding < b.binding;
+	});
+
+	const uint64_t key = hashBindGroup(layout, sorted);
+	auto range = m_entries.equal_range(key);
+	for (auto it = range.first; it != range.second; ++it) {
+		const Entry& entry = it->second;
+		if (entry.layout == layout && std::equal(entry.entries.begin(), entry.entries.end(), sorted.begin(), sorted.end(), sameEntry)) {
+			++m_hitCount;
+			return entry.bindGroup;
+		}
+	}
+
+	++m_missCount;
+	WGPUBindGroupDescriptor bindGroupDesc = WGPU_BIND_GROUP_DESCRIPTOR_INIT;
+	bindGroupDesc.layout = layout;
+	bindGroupDesc.entryCount = sorted.size();
+	bindGroupDesc.entries = sorted.data();
+	WGPUBindGroup bindGroup = wgpuDeviceCreateBindGroup(m_device, &bindGroupDesc);
+	if (bindGroup == nullptr) return nullptr;
+
+	// The layout and resources are part of the key
+	wgpuBindGroupLayoutAddRef(layout);
+	for (const WGPUBindGroupEntry& entry : sorted) {
+		if (entry.buffer) wgpuBufferAddRef(entry.buffer);
+		if (entry.sampler) wgpuSamplerAddRef(entry.sampler);
+		if (entry.textureView) wgpuTextureViewAddRef(entry.textureView);
+	}
+	m_entries.emplace(key, Entry{ layout, std::move(sorted), bindGroup });
+	return bindGroup;
+}
+
+void BindGroupCache::evictResource(const void* resource)
+{
+	if (resource == nullptr) return;
+	for (auto it = m_entries.begin(); it != m_entries.end();) {
+		const std::vector<WGPUBindGroupEntry>& entries = it->second.entries;
+		bool usesResource = std::any_of(entries.begin(), entries.end(), [&](const WGPUBindGroupEntry& entry) {
+			return entry.buffer == resource || entry.sampler == resource || entry.textureView == resource;
+		});
+		if (usesResource) {
+			releaseEntry(it->second);
+			it = m_entries.erase(it);
+		}
+		else {
+			++it;
+		}
+	}
+}
+
+void BindGroupCache::releaseEntry(const Entry& entry)
+{
+	wgpuBindGroupRelease(entry.bindGroup);
+	wgpuBindGroupLayoutRelease(entry.layout);
+	for (const WGPUBindGroupEntry& binding : entry.entries) {
+		if (binding.buffer) wgpuBufferRelease(binding.buffer);
+		if (binding.sampler) wgpuSamplerRelease(binding.sampler);
+		if (binding.textureView) wgpuTextureViewRelease(binding.textureView);
+	}
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include <webgpu/webgpu.h>
+
+/**
+ * Bind groups of a device, created once per layout and set of bound
+ * resources (buffer ranges, texture views and samplers) and reused across
+ * frames. Looking a bind group up is much cheaper than creating it, so
+ * bind groups can be asked for whenever they are needed, e.g. per object.
+ *
+ * Bind groups are owned by the cache: the handles it returns are borrowed.
+ * Like pipelines, each one references the handles it is keyed on, here its
+ * layout and resources, and the cache has the same threading rules (see
+ * RenderPipelineCache). The owner of a resource evicts it before releasing
+ * it, which also drops the bind groups that use it.
+ */
+class BindGroupCache
+{
+public:
+	explicit BindGroupCache(WGPUDevice device);
+	~BindGroupCache();
+
+	BindGroupCache(const BindGroupCache&) = delete;
+	BindGroupCache& operator=(const BindGroupCache&) = delete;
+
+	/**
+	 * Bind group of `layout` binding `entries`, in any order, created on
+	 * first use.
+	 */
+	WGPUBindGroup bindGroup(WGPUBindGroupLayout layout, const std::vector<WGPUBindGroupEntry>& entries);
+
+	/**
+	 * Release the bind groups that bind a resource, which is about to be
+	 * released by its owner.
+	 */
+	void evict(WGPUBuffer buffer) { evictResource(buffer); }
+	void evict(WGPUTextureView textureView) { evictResource(textureView); }
+	void evict(WGPUSampler sampler) { evictResource(sampler); }
+
+	size_t size() const { return m_entries.size(); }
+	// Number of bindGroup() calls served without creating a bind group
+	uint64_t hitCount() const { return m_hitCount; }
+	uint64_t missCount() const { return m_missCount; }
+
+private:
+	struct Entry
+	{
+		WGPUBindGroupLayout layout;
+		// Sorted by binding
+		std::vector<WGPUBindGroupEntry> entries;
+		WGPUBindGroup bindGroup;
+	};
+
+	void evictResource(const void* resource);
+	static void releaseEntry(const Entry& entry);
+
+	WGPUDevice m_device;
+	// By hash of the layout and entries, compared on lookup
+	std::unordered_multimap<uint64_t, Entry> m_entries;
+	uint64_t m_hitCount = 0;
+	uint64_t m_missCount = 0;
+};
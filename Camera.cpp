@@ -0,0 +1,50 @@
+#include "Camera.h"
+
+#include <algorithm>
+#include <cmath>
+
+Camera::Camera()
+{
+	updateProjection();
+}
+
+void Camera::setPerspective(float focalLength, float near, float far)
+{
+	m_focalLength = focalLength;
+	m_near = near;
+	m_far = far;
+	updateProjection();
+}
+
+void Camera::setViewport(uint32_t width, uint32_t height)
+{
+	// A minimized window has an empty framebuffer
+	m_width = std::max(width, 1u);
+	m_height = std::max(height, 1u);
+	updateProjection();
+}
+
+float Camera::pixelsPerUnit() const
+{
+	// The projection maps y = 1 / focalLength to the top edge
+	return 0.5f * static_cast<float>(m_height) * m_focalLength;
+}
+
+bool Camera::isSphereVisible(const std::array<float, 3>& center, float radius) const
+{
+	// Same test as the meshlet culling pass: the side planes are
+	// |xScale * x| <= z and |yScale * y| <= z
+	const float xScale = m_projection.at(0, 0);
+	const float yScale = m_projection.at(1, 1);
+	const float sideLength = std::sqrt(xScale * xScale + 1.0f);
+	const float topLength = std::sqrt(yScale * yScale + 1.0f);
+	if (std::abs(xScale * center[0]) - center[2] > radius * sideLength) return false;
+	if (std::abs(yScale * center[1]) - center[2] > radius * topLength) return false;
+	return center[2] + radius >= m_near && center[2] - radius <= m_far;
+}
+
+void Camera::updateProjection()
+{
+	const float aspectRatio = static_cast<float>(m_width) / static_cast<float>(m_height);
+	m_projection = Mat4::perspective(m_focalLength, aspectRatio, m_near, m_far);
+}
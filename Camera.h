@@ -0,0 +1,57 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include "Mat4.h"
+
+/**
+ * A perspective camera: the view transform, from world space to a view
+ * space where the camera sits at the origin and looks towards +Z with Y up,
+ * and the projection to clip space. The aspect ratio follows the size of
+ * the render target rather than being baked into the shader.
+ */
+class Camera
+{
+public:
+	Camera();
+
+	void setView(const Mat4& view) { m_view = view; }
+
+	/**
+	 * `focalLength` is 1 / tan(vertical field of view / 2).
+	 */
+	void setPerspective(float focalLength, float near, float far);
+
+	/**
+	 * Size of the render target, in pixels.
+	 */
+	void setViewport(uint32_t width, uint32_t height);
+
+	const Mat4& view() const { return m_view; }
+	const Mat4& projection() const { return m_projection; }
+
+	float nearPlane() const { return m_near; }
+	float farPlane() const { return m_far; }
+
+	/**
+	 * Pixels covered on screen by a view space length of 1 at a distance of
+	 * 1 along the view axis, e.g. to turn errors into pixels.
+	 */
+	float pixelsPerUnit() const;
+
+	/**
+	 * Whether a sphere given in view space intersects the view frustum.
+	 * Conservative near the corners of the frustum.
+	 */
+	bool isSphereVisible(const std::array<float, 3>& center, float radius) const;
+
+private:
+	void updateProjection();
+
+	Mat4 m_view;
+	Mat4 m_projection;
+	float m_focalLength = 1.0f;
+	float m_near = 0.01f;
+	float m_far = 100.0f;
+	uint32_t m_width = 1;
+	uint32_t m_height = 1;
+};
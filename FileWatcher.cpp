@@ -0,0 +1,131 @@
+#include "FileWatcher.h"
+
+#include <algorithm>
+#include <iostream>
+#include <system_error>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <cerrno>
+#define FILE_WATCHER_INOTIFY 1
+#else
+#define FILE_WATCHER_INOTIFY 0
+#endif
+
+FileWatcher::~FileWatcher()
+{
+#if FILE_WATCHER_INOTIFY
+	if (m_inotify >= 0) ::close(m_inotify);
+#endif
+}
+
+bool FileWatcher::watch(const std::filesystem::path& path)
+{
+	for (const WatchedFile& watched : m_files) {
+		if (watched.path == path) return true;
+	}
+
+	std::error_code ec;
+	WatchedFile file;
+	file.path = path;
+	file.absolutePath = std::filesystem::weakly_canonical(path, ec);
+	if (ec) file.absolutePath = std::filesystem::absolute(path, ec).lexically_normal();
+	if (!std::filesystem::is_directory(file.absolutePath.parent_path(), ec)) {
+		std::cerr << "Could not watch " << path << ": no such directory" << std::endl;
+		return false;
+	}
+	stamp(file);
+
+#if FILE_WATCHER_INOTIFY
+	if (m_inotify < 0 && !m_inotifyFailed) {
+		m_inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+		m_inotifyFailed = m_inotify < 0;
+	}
+	if (m_inotify >= 0) {
+		// Watch the directory rather than the file: editors often save by
+		// writing a new file and renaming it over the old one.
+		file.watchDescriptor = inotify_add_watch(
+			m_inotify, file.absolutePath.parent_path().c_str(),
+			IN_CLOSE_WRITE | IN_MOVED_TO
+		);
+		if (file.watchDescriptor < 0) {
+			// Typically out of watches, poll everything instead
+			::close(m_inotify);
+			m_inotify = -1;
+			m_inotifyFailed = true;
+		}
+	}
+#endif
+
+	m_files.push_back(std::move(file));
+	return true;
+}
+
+std::vector<std::filesystem::path> FileWatcher::poll()
+{
+	return usesInotify() ? pollInotify() : pollTimestamps();
+}
+
+void FileWatcher::stamp(WatchedFile& file)
+{
+	std::error_code ec;
+	file.lastWriteTime = std::filesystem::last_write_time(file.absolutePath, ec);
+	if (ec) file.lastWriteTime = {};
+	file.size = std::filesystem::file_size(file.absolutePath, ec);
+	if (ec) file.size = 0;
+}
+
+std::vector<std::filesystem::path> FileWatcher::pollInotify()
+{
+	std::vector<std::filesystem::path> changed;
+#if FILE_WATCHER_INOTIFY
+	auto report = [&changed](const WatchedFile& file) {
+		if (std::find(changed.begin(), changed.end(), file.path) == changed.end()) {
+			changed.push_back(file.path);
+		}
+	};
+
+	alignas(inotify_event) char buffer[4096];
+	for (;;) {
+		ssize_t length = ::read(m_inotify, buffer, sizeof(buffer));
+		if (length <= 0) break; // EAGAIN once the queue is drained
+
+		for (ssize_t offset = 0; offset < length;) {
+			const inotify_event* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+			offset += sizeof(inotify_event) + event->len;
+
+			if (event->mask & IN_Q_OVERFLOW) {
+				// Events were dropped, assume everything changed
+				for (const WatchedFile& file : m_files) report(file);
+				continue;
+			}
+			if (event->len == 0) continue;
+			for (const WatchedFile& file : m_files) {
+				if (file.watchDescriptor == event->wd && file.absolutePath.filename() == event->name) {
+					report(file);
+				}
+			}
+		}
+	}
+#endif
+	return changed;
+}
+
+std::vector<std::filesystem::path> FileWatcher::pollTimestamps()
+{
+	std::vector<std::filesystem::path> changed;
+	auto now = std::chrono::steady_clock::now();
+	if (now < m_nextScan) return changed;
+	m_nextScan = now + PollInterval;
+
+	for (WatchedFile& file : m_files) {
+		std::filesystem::file_time_type lastWriteTime = file.lastWriteTime;
+		uintmax_t size = file.size;
+		stamp(file);
+		if (file.lastWriteTime != lastWriteTime || file.size != size) {
+			changed.push_back(file.path);
+		}
+	}
+	return changed;
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+/**
+ * Report the files that changed on disk, for hot reloading. Changes are
+ * received from inotify on Linux; elsewhere, or if inotify is not available,
+ * modification times and sizes are compared every PollInterval instead.
+ *
+ * Meant to be polled from a single thread, once per frame.
+ */
+class FileWatcher
+{
+public:
+	static constexpr std::chrono::milliseconds PollInterval{ 250 };
+
+	FileWatcher() = default;
+	~FileWatcher();
+
+	FileWatcher(const FileWatcher&) = delete;
+	FileWatcher& operator=(const FileWatcher&) = delete;
+
+	/**
+	 * Start watching the file at `path`. The file does not need to exist yet
+	 * but its directory does. Watching a file twice has no effect.
+	 */
+	bool watch(const std::filesystem::path& path);
+
+	/**
+	 * Watched files that changed since the last call, each reported once and
+	 * with the path given to watch().
+	 */
+	std::vector<std::filesystem::path> poll();
+
+	bool usesInotify() const { return m_inotify >= 0; }
+
+private:
+	struct WatchedFile
+	{
+		std::filesystem::path path;
+		// Normalized, to be compared with the names reported by inotify
+		std::filesystem::path absolutePath;
+		std::filesystem::file_time_type lastWriteTime;
+		uintmax_t size = 0;
+		int watchDescriptor = -1;
+	};
+
+	void stamp(WatchedFile& file);
+	std::vector<std::filesystem::path> pollInotify();
+	std::vector<std::filesystem::path> pollTimestamps();
+
+private:
+	std::vector<WatchedFile> m_files;
+	int m_inotify = -1;
+	bool m_inotifyFailed = false;
+	std::chrono::steady_clock::time_point m_nextScan;
+};
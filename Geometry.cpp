@@ -0,0 +1,179 @@
+#include "Geometry.h"
+
+#include <iostream>
+#include <iterator>
+#include <utility>
+
+bool VertexLayout::floatLayout(int dimensions, VertexLayout& layout)
+{
+	static const WGPUVertexFormat floatFormats[] = {
+		WGPUVertexFormat_Float32,
+		WGPUVertexFormat_Float32x2,
+		WGPUVertexFormat_Float32x3,
+		WGPUVertexFormat_Float32x4,
+	};
+	if (dimensions < 1 || dimensions > static_cast<int>(std::size(floatFormats))) {
+		std::cerr << "Unsupported geometry dimensions: " << dimensions << " (expected 1 to " << std::size(floatFormats) << ")" << std::endl;
+		return false;
+	}
+	layout = VertexLayout();
+	layout.positionFormat = floatFormats[dimensions - 1];
+	layout.colorFormat = WGPUVertexFormat_Float32x3;
+	layout.positionOffset = 0;
+	layout.colorOffset = static_cast<uint32_t>(dimensions * sizeof(float));
+	layout.stride = static_cast<uint32_t>((dimensions + 3) * sizeof(float));
+	return true;
+}
+
+WGPUVertexBufferLayout VertexLayout::bufferLayout(std::array<WGPUVertexAttribute, 2>& attributes) const
+{
+	// Describe the position attribute
+	attributes[0].shaderLocation = 0; // @location(0)
+	attributes[0].format = positionFormat;
+	attributes[0].offset = positionOffset;
+	// Describe the color attribute
+	attributes[1].shaderLocation = 1; // @location(1)
+	attributes[1].format = colorFormat;
+	attributes[1].offset = colorOffset;
+
+	WGPUVertexBufferLayout vertexBufferLayout = WGPU_VERTEX_BUFFER_LAYOUT_INIT;
+	vertexBufferLayout.attributeCount = static_cast<uint32_t>(attributes.size());
+	vertexBufferLayout.attributes = attributes.data();
+	vertexBufferLayout.arrayStride = stride;
+	vertexBufferLayout.stepMode = WGPUVertexStepMode_Vertex;
+	return vertexBufferLayout;
+}
+
+bool VertexLayout::sameFormat(const VertexLayout& other) const
+{
+	return positionFormat == other.positionFormat && colorFormat == other.colorFormat
+		&& positionOffset == other.positionOffset && colorOffset == other.colorOffset
+		&& stride == other.stride;
+}
+
+WGPUIndexFormat Geometry::indexFormatFor(size_t vertexCount)
+{
+	return vertexCount <= size_t(UINT16_MAX) + 1 ? WGPUIndexFormat_Uint16 : WGPUIndexFormat_Uint32;
+}
+
+size_t Geometry::indexSize(WGPUIndexFormat format)
+{
+	return format == WGPUIndexFormat_Uint32 ? sizeof(uint32_t) : sizeof(uint16_t);
+}
+
+size_t Geometry::indexDataSize(WGPUIndexFormat format, size_t indexCount)
+{
+	return (indexCount * indexSize(format) + 3) & ~size_t(3);
+}
+
+void Geometry::setVertices(std::vector<float>&& pointData, const VertexLayout& layout)
+{
+	m_file.close();
+	m_encodedVertices.clear();
+	m_points = std::move(pointData);
+	m_vertexLayout = layout;
+	m_vertexData = m_points.data();
+	m_vertexCount = m_points.size() * sizeof(float) / layout.stride;
+}
+
+void Geometry::setVertices(std::vector<uint8_t>&& vertexData, const VertexLayout& layout)
+{
+	m_file.close();
+	m_points.clear();
+	m_encodedVertices = std::move(vertexData);
+	m_vertexLayout = layout;
+	m_vertexData = m_encodedVertices.data();
+	m_vertexCount = m_encodedVertices.size() / layout.stride;
+}
+
+void Geometry::setIndices(std::vector<uint16_t>&& indexData)
+{
+	m_file.close();
+	m_indices32.clear();
+	m_indices16 = std::move(indexData);
+
+	m_indexCount = m_indices16.size();
+	m_indices16.resize((m_indices16.size() + 1) & ~size_t(1)); // round up to the next multiple of 2
+
+	m_indexData = m_indices16.data();
+	m_indexFormat = WGPUIndexFormat_Uint16;
+	m_meshletData = nullptr;
+	m_meshletCount = 0;
+	m_lodData = nullptr;
+	m_lodCount = 0;
+}
+
+void Geometry::setIndices(std::vector<uint32_t>&& indexData)
+{
+	m_file.close();
+	m_indices16.clear();
+	m_indices32 = std::move(indexData);
+
+	m_indexData = m_indices32.data();
+	m_indexCount = m_indices32.size();
+	m_indexFormat = WGPUIndexFormat_Uint32;
+	m_meshletData = nullptr;
+	m_meshletCount = 0;
+	m_lodData = nullptr;
+	m_lodCount = 0;
+}
+
+void Geometry::setMeshlets(std::vector<Meshlet>&& meshlets)
+{
+	m_file.close();
+	m_meshlets = std::move(meshlets);
+	m_meshletData = m_meshlets.data();
+	m_meshletCount = m_meshlets.size();
+}
+
+void Geometry::setLods(std::vector<MeshLod>&& lods)
+{
+	m_file.close();
+	m_lods = std::move(lods);
+	m_lodData = m_lods.data();
+	m_lodCount = m_lods.size();
+}
+
+void Geometry::assign(
+	MappedFile&& file,
+	const void* vertexData, size_t vertexCount, const VertexLayout& layout,
+	const void* indexData, size_t indexCount, WGPUIndexFormat indexFormat,
+	const Meshlet* meshletData, size_t meshletCount,
+	const MeshLod* lodData, size_t lodCount
+)
+{
+	clear();
+	m_file = std::move(file);
+	m_vertexData = vertexData;
+	m_vertexCount = vertexCount;
+	m_vertexLayout = layout;
+	m_indexData = indexData;
+	m_indexCount = indexCount;
+	m_indexFormat = indexFormat;
+	m_meshletData = meshletData;
+	m_meshletCount = meshletCount;
+	m_lodData = lodData;
+	m_lodCount = lodCount;
+}
+
+void Geometry::clear()
+{
+	m_points.clear();
+	m_encodedVertices.clear();
+	m_indices16.clear();
+	m_indices32.clear();
+	m_meshlets.clear();
+	m_lods.clear();
+	m_file.close();
+	m_vertexData = nullptr;
+	m_vertexCount = 0;
+	m_vertexLayout = VertexLayout();
+	m_indexData = nullptr;
+	m_indexCount = 0;
+	m_indexFormat = WGPUIndexFormat_Uint16;
+	m_meshletData = nullptr;
+	m_meshletCount = 0;
+	m_lodData = nullptr;
+	m_lodCount = 0;
+	m_bounds = MeshBounds();
+}
@@ -0,0 +1,191 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <webgpu/webgpu.h>
+#include "MappedFile.h"
+#include "MeshBounds.h"
+#include "MeshletBuilder.h"
+#include "MeshSimplifier.h"
+
+/**
+ * Optional processing steps applied to geometry after parsing, as a bit mask.
+ * The binary mesh cache records which steps its content went through.
+ */
+typedef uint32_t GeometryProcessing;
+static const GeometryProcessing GeometryProcessing_None = 0;
+// Reorder triangles and vertices for vertex cache, overdraw and fetch (see MeshOptimizer)
+static const GeometryProcessing GeometryProcessing_Optimize = 1 << 0;
+// Store positions as Float16x4 and colors as Unorm8x4 (see VertexQuantizer)
+static const GeometryProcessing GeometryProcessing_QuantizeHalf = 1 << 1;
+// Store positions as Snorm16x4 relative to the mesh AABB and colors as Unorm8x4.
+// Takes precedence over GeometryProcessing_QuantizeHalf.
+static const GeometryProcessing GeometryProcessing_QuantizeSnorm16 = 1 << 2;
+// Split triangles into meshlets for GPU culling (see MeshletBuilder)
+static const GeometryProcessing GeometryProcessing_Meshlets = 1 << 3;
+// Append simplified levels of detail to the index buffer (see MeshSimplifier)
+static const GeometryProcessing GeometryProcessing_Lods = 1 << 4;
+
+/**
+ * How vertices are laid out in the vertex buffer: one interleaved position
+ * and color per vertex. Quantized positions are decoded in the vertex shader
+ * as `positionBias + positionScale * position`.
+ */
+struct VertexLayout
+{
+	WGPUVertexFormat positionFormat = WGPUVertexFormat_Float32x3;
+	WGPUVertexFormat colorFormat = WGPUVertexFormat_Float32x3;
+	uint32_t positionOffset = 0;
+	uint32_t colorOffset = 3 * sizeof(float);
+	uint32_t stride = 6 * sizeof(float);
+	uint32_t _pad = 0;
+	std::array<float, 4> positionScale = { 1.0f, 1.0f, 1.0f, 1.0f };
+	std::array<float, 4> positionBias = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+	/**
+	 * Layout of the raw float points produced by the parser. Return false if
+	 * there is no vertex format for `dimensions`, i.e. it is not between 1
+	 * and 4, which is reported.
+	 */
+	static bool floatLayout(int dimensions, VertexLayout& layout);
+
+	/**
+	 * Fill `attributes` (@location(0) position, @location(1) color) and
+	 * return the matching buffer layout, which points into `attributes`.
+	 */
+	WGPUVertexBufferLayout bufferLayout(std::array<WGPUVertexAttribute, 2>& attributes) const;
+
+	/**
+	 * Whether vertices in both layouts can be fetched by the same pipeline,
+	 * i.e. they only differ by their dequantization.
+	 */
+	bool sameFormat(const VertexLayout& other) const;
+};
+
+/**
+ * Geometry loaded by the ResourceManager, ready to be uploaded to the GPU.
+ * The data is either owned in CPU-side vectors (freshly parsed text file) or
+ * points directly into a memory-mapped binary mesh cache, in which case no
+ * copy is ever made before wgpuQueueWriteBuffer.
+ *
+ * Indices are 16-bit whenever the vertex count allows it, since that halves
+ * index bandwidth, and 32-bit otherwise (see indexFormatFor()).
+ */
+class Geometry
+{
+public:
+	/**
+	 * Index format able to address `vertexCount` vertices.
+	 */
+	static WGPUIndexFormat indexFormatFor(size_t vertexCount);
+
+	/**
+	 * Size in bytes of one index of the given format.
+	 */
+	static size_t indexSize(WGPUIndexFormat format);
+
+	/**
+	 * Size in bytes of `indexCount` indices of the given format, rounded up
+	 * to a multiple of 4 as required by wgpuQueueWriteBuffer.
+	 */
+	static size_t indexDataSize(WGPUIndexFormat format, size_t indexCount);
+
+	/**
+	 * Take ownership of parsed float points, laid out as `layout` describes.
+	 */
+	void setVertices(std::vector<float>&& pointData, const VertexLayout& layout);
+
+	/**
+	 * Take ownership of already encoded (e.g. quantized) vertices.
+	 */
+	void setVertices(std::vector<uint8_t>&& vertexData, const VertexLayout& layout);
+
+	/**
+	 * Take ownership of indices. The 16-bit index vector is padded so that
+	 * indexDataSize() is a multiple of 4 bytes. Meshlets and levels of
+	 * detail refer to the previous indices, so they are dropped.
+	 */
+	void setIndices(std::vector<uint16_t>&& indexData);
+	void setIndices(std::vector<uint32_t>&& indexData);
+
+	/**
+	 * Take ownership of meshlets covering the index buffer.
+	 */
+	void setMeshlets(std::vector<Meshlet>&& meshlets);
+
+	/**
+	 * Take ownership of the levels of detail stored in the index buffer.
+	 */
+	void setLods(std::vector<MeshLod>&& lods);
+
+	/**
+	 * Bounds of the vertices, as computed by the parser. Unlike the other
+	 * setters, this keeps a mapped file mapped.
+	 */
+	void setBounds(const MeshBounds& bounds) { m_bounds = bounds; }
+
+	/**
+	 * Take ownership of a mapped file and expose the given ranges of it.
+	 * The index range must already include the 4-byte padding.
+	 */
+	void assign(
+		MappedFile&& file,
+		const void* vertexData, size_t vertexCount, const VertexLayout& layout,
+		const void* indexData, size_t indexCount, WGPUIndexFormat indexFormat,
+		const Meshlet* meshletData = nullptr, size_t meshletCount = 0,
+		const MeshLod* lodData = nullptr, size_t lodCount = 0
+	);
+
+	void clear();
+
+	size_t vertexCount() const { return m_vertexCount; }
+	const void* vertexData() const { return m_vertexData; }
+	size_t vertexDataSize() const { return m_vertexCount * m_vertexLayout.stride; }
+	const VertexLayout& vertexLayout() const { return m_vertexLayout; }
+
+	// Number of indices, excluding padding
+	size_t indexCount() const { return m_indexCount; }
+	// Either uint16_t or uint32_t values, depending on indexFormat()
+	const void* indexData() const { return m_indexData; }
+	WGPUIndexFormat indexFormat() const { return m_indexFormat; }
+	// Size in bytes of the index data, rounded up to a multiple of 4 as
+	// required by wgpuQueueWriteBuffer
+	size_t indexDataSize() const { return indexDataSize(m_indexFormat, m_indexCount); }
+
+	// Empty unless built with GeometryProcessing_Meshlets
+	size_t meshletCount() const { return m_meshletCount; }
+	const Meshlet* meshletData() const { return m_meshletData; }
+	size_t meshletDataSize() const { return m_meshletCount * sizeof(Meshlet); }
+
+	// Empty unless built with GeometryProcessing_Lods, otherwise the first
+	// level is the base mesh
+	size_t lodCount() const { return m_lodCount; }
+	const MeshLod* lodData() const { return m_lodData; }
+
+	// Empty if the loader did not compute them
+	const MeshBounds& bounds() const { return m_bounds; }
+
+	bool isMapped() const { return m_file.isOpen(); }
+
+private:
+	std::vector<float> m_points;
+	std::vector<uint8_t> m_encodedVertices;
+	std::vector<uint16_t> m_indices16;
+	std::vector<uint32_t> m_indices32;
+	std::vector<Meshlet> m_meshlets;
+	std::vector<MeshLod> m_lods;
+	MappedFile m_file;
+
+	const void* m_vertexData = nullptr;
+	size_t m_vertexCount = 0;
+	VertexLayout m_vertexLayout;
+	const void* m_indexData = nullptr;
+	size_t m_indexCount = 0;
+	WGPUIndexFormat m_indexFormat = WGPUIndexFormat_Uint16;
+	const Meshlet* m_meshletData = nullptr;
+	size_t m_meshletCount = 0;
+	const MeshLod* m_lodData = nullptr;
+	size_t m_lodCount = 0;
+	MeshBounds m_bounds;
+};
@@ -0,0 +1,314 @@
+#include "GeometryParser.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <string_view>
+
+#if !defined(__EMSCRIPTEN__) || defined(__EMSCRIPTEN_PTHREADS__)
+#  define GEOMETRY_PARSER_THREADS
+#  include <thread>
+#endif
+
+using Section = GeometryParser::Section;
+using Chunk = GeometryParser::Chunk;
+
+namespace
+{
+	enum class LineKind {
+		Ignored,
+		PointsHeader,
+		IndicesHeader,
+		Data,
+	};
+
+	// Below this many bytes per chunk, thread startup costs more than it saves
+	constexpr size_t MinChunkSize = 1 << 20;
+
+	bool isBlank(char c)
+	{
+		return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+	}
+
+	/**
+	 * Return the end of the line starting at `cursor` (excluding '\n') and
+	 * move `next` to the beginning of the following line.
+	 */
+	const char* findLineEnd(const char* cursor, const char* end, const char*& next)
+	{
+		const void* newline = std::memchr(cursor, '\n', static_cast<size_t>(end - cursor));
+		if (newline == nullptr) {
+			next = end;
+			return end;
+		}
+		next = static_cast<const char*>(newline) + 1;
+		return static_cast<const char*>(newline);
+	}
+
+	LineKind classify(const char* lineBegin, const char*& lineEnd)
+	{
+		// overcome the `CRLF` problem
+		if (lineEnd != lineBegin && lineEnd[-1] == '\r') {
+			--lineEnd;
+		}
+
+		std::string_view line(lineBegin, static_cast<size_t>(lineEnd - lineBegin));
+		if (line == "[points]") return LineKind::PointsHeader;
+		if (line == "[indices]") return LineKind::IndicesHeader;
+		if (line.empty() || line[0] == '#') return LineKind::Ignored;
+
+		for (char c : line) {
+			if (!isBlank(c)) return LineKind::Data;
+		}
+		return LineKind::Ignored;
+	}
+
+	/**
+	 * Read the next number of the line into `value`. On failure `value` is set
+	 * to 0 and `cursor` is moved to the end of the line, so that the remaining
+	 * values of the line are 0 as well.
+	 */
+	template <typename T>
+	void readValue(const char*& cursor, const char* lineEnd, T& value)
+	{
+		while (cursor != lineEnd && isBlank(*cursor)) ++cursor;
+		// std::from_chars does not accept an explicit plus sign
+		if (cursor != lineEnd && *cursor == '+') ++cursor;
+
+		auto result = std::from_chars(cursor, lineEnd, value);
+		if (result.ec != std::errc()) {
+			value = T(0);
+			cursor = lineEnd;
+			return;
+		}
+		cursor = result.ptr;
+	}
+
+	void scanChunk(Chunk& chunk)
+	{
+		Section currentSection = Section::None;
+		for (const char* cursor = chunk.begin; cursor != chunk.end;) {
+			const char* next;
+			const char* lineEnd = findLineEnd(cursor, chunk.end, next);
+			switch (classify(cursor, lineEnd)) {
+			case LineKind::PointsHeader: currentSection = Section::Points; break;
+			case LineKind::IndicesHeader: currentSection = Section::Indices; break;
+			case LineKind::Ignored: break;
+			case LineKind::Data:
+				if (currentSection == Section::Points) ++chunk.pointLines;
+				else if (currentSection == Section::Indices) ++chunk.indexLines;
+				else ++chunk.leadingDataLines;
+				break;
+			}
+			cursor = next;
+		}
+		chunk.lastHeader = currentSection;
+	}
+
+	/**
+	 * Run `task(i)` for each i in [0, count), on up to `count` threads.
+	 */
+	template <typename Task>
+	void runParallel(size_t count, const Task& task)
+	{
+#ifdef GEOMETRY_PARSER_THREADS
+		if (count > 1) {
+			std::vector<std::thread> workers;
+			workers.reserve(count - 1);
+			for (size_t i = 1; i < count; ++i) {
+				workers.emplace_back(task, i);
+			}
+			task(0);
+			for (std::thread& worker : workers) {
+				worker.join();
+			}
+			return;
+		}
+#endif // GEOMETRY_PARSER_THREADS
+		for (size_t i = 0; i < count; ++i) {
+			task(i);
+		}
+	}
+
+	template <typename Index>
+	void parseChunkImpl(const Chunk& chunk, float* point, Index* index, int dimensions)
+	{
+		const size_t pointStride = static_cast<size_t>(dimensions) + 3;
+		Section currentSection = chunk.startSection;
+		for (const char* cursor = chunk.begin; cursor != chunk.end;) {
+			const char* next;
+			const char* lineEnd = findLineEnd(cursor, chunk.end, next);
+			switch (classify(cursor, lineEnd)) {
+			case LineKind::PointsHeader: currentSection = Section::Points; break;
+			case LineKind::IndicesHeader: currentSection = Section::Indices; break;
+			case LineKind::Ignored: break;
+			case LineKind::Data:
+				if (currentSection == Section::Points) {
+					// Get x, y, r, g, b
+					for (size_t i = 0; i < pointStride; ++i) {
+						readValue(cursor, lineEnd, *point++);
+					}
+				}
+				else if (currentSection == Section::Indices) {
+					// Get corners #0 #1 and #2
+					for (int i = 0; i < 3; ++i) {
+						readValue(cursor, lineEnd, *index++);
+					}
+				}
+				break;
+			}
+			cursor = next;
+		}
+	}
+
+	template <typename Index>
+	void parseImpl(
+		const char* begin,
+		const char* end,
+		std::vector<float>& pointData,
+		std::vector<Index>& indexData,
+		int dimensions,
+		unsigned threadCount,
+		MeshBounds* bounds
+	)
+	{
+		if (threadCount == 0) {
+			threadCount = GeometryParser::defaultThreadCount(static_cast<size_t>(end - begin));
+		}
+
+		// First pass: count data lines per chunk, so that the output vectors are
+		// allocated exactly once.
+		std::vector<Chunk> chunks = GeometryParser::split(begin, end, threadCount, dimensions, threadCount);
+		pointData.clear();
+		indexData.clear();
+		if (!chunks.empty()) {
+			pointData.resize(chunks.back().pointOffset + chunks.back().pointCount);
+			indexData.resize(chunks.back().indexOffset + chunks.back().indexCount);
+		}
+
+		// Second pass: each chunk parses in place, writing directly into its own
+		// slice of the output, so the result does not depend on the chunking.
+		float* points = pointData.data();
+		Index* indices = indexData.data();
+		const size_t pointStride = static_cast<size_t>(dimensions) + 3;
+		std::vector<MeshBounds> chunkBounds(bounds ? chunks.size() : 0);
+		runParallel(chunks.size(), [&](size_t i) {
+			parseChunkImpl(chunks[i], points + chunks[i].pointOffset, indices + chunks[i].indexOffset, dimensions);
+			if (bounds) {
+				chunkBounds[i] = MeshBounds::fromPoints(points + chunks[i].pointOffset, chunks[i].pointCount / pointStride, dimensions);
+			}
+		});
+
+		if (bounds) {
+			*bounds = MeshBounds();
+			for (const MeshBounds& chunk : chunkBounds) bounds->merge(chunk);
+		}
+	}
+}
+
+unsigned GeometryParser::defaultThreadCount(size_t size)
+{
+#ifdef GEOMETRY_PARSER_THREADS
+	unsigned hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+	size_t sizeLimited = std::max<size_t>(1, size / MinChunkSize);
+	return static_cast<unsigned>(std::min<size_t>(hardwareThreads, sizeLimited));
+#else
+	(void)size;
+	return 1;
+#endif
+}
+
+std::vector<Chunk> GeometryParser::split(
+	const char* begin,
+	const char* end,
+	size_t chunkCount,
+	int dimensions,
+	unsigned threadCount
+)
+{
+	std::vector<Chunk> chunks;
+	const size_t size = static_cast<size_t>(end - begin);
+	chunkCount = std::max<size_t>(chunkCount, 1);
+	const char* cursor = begin;
+	for (size_t i = 1; i <= chunkCount && cursor != end; ++i) {
+		const char* chunkEnd = end;
+		if (i < chunkCount) {
+			const char* target = std::max(cursor, begin + size / chunkCount * i);
+			const void* newline = std::memchr(target, '\n', static_cast<size_t>(end - target));
+			chunkEnd = newline ? static_cast<const char*>(newline) + 1 : end;
+		}
+		if (chunkEnd == cursor) continue;
+		Chunk chunk;
+		chunk.begin = cursor;
+		chunk.end = chunkEnd;
+		chunks.push_back(chunk);
+		cursor = chunkEnd;
+	}
+
+	// Scan chunks in batches of `threadCount`, each on its own thread
+	threadCount = std::max(threadCount, 1u);
+	for (size_t first = 0; first < chunks.size(); first += threadCount) {
+		size_t count = std::min<size_t>(threadCount, chunks.size() - first);
+		runParallel(count, [&chunks, first](size_t i) { scanChunk(chunks[first + i]); });
+	}
+
+	// Resolve in file order the section each chunk starts in and where its
+	// values land in the output.
+	const size_t pointStride = static_cast<size_t>(dimensions) + 3;
+	Section currentSection = Section::None;
+	size_t pointLineCount = 0;
+	size_t indexLineCount = 0;
+	for (Chunk& chunk : chunks) {
+		chunk.startSection = currentSection;
+		size_t chunkPointLines = chunk.pointLines;
+		size_t chunkIndexLines = chunk.indexLines;
+		if (currentSection == Section::Points) chunkPointLines += chunk.leadingDataLines;
+		else if (currentSection == Section::Indices) chunkIndexLines += chunk.leadingDataLines;
+
+		chunk.pointOffset = pointLineCount * pointStride;
+		chunk.pointCount = chunkPointLines * pointStride;
+		chunk.indexOffset = indexLineCount * 3;
+		chunk.indexCount = chunkIndexLines * 3;
+		pointLineCount += chunkPointLines;
+		indexLineCount += chunkIndexLines;
+
+		if (chunk.lastHeader != Section::None) currentSection = chunk.lastHeader;
+	}
+	return chunks;
+}
+
+void GeometryParser::parse(
+	const char* begin,
+	const char* end,
+	std::vector<float>& pointData,
+	std::vector<uint16_t>& indexData,
+	int dimensions,
+	unsigned threadCount,
+	MeshBounds* bounds
+)
+{
+	parseImpl(begin, end, pointData, indexData, dimensions, threadCount, bounds);
+}
+
+void GeometryParser::parse(
+	const char* begin,
+	const char* end,
+	std::vector<float>& pointData,
+	std::vector<uint32_t>& indexData,
+	int dimensions,
+	unsigned threadCount,
+	MeshBounds* bounds
+)
+{
+	parseImpl(begin, end, pointData, indexData, dimensions, threadCount, bounds);
+}
+
+void GeometryParser::parseChunk(const Chunk& chunk, float* pointData, uint16_t* indexData, int dimensions)
+{
+	parseChunkImpl(chunk, pointData, indexData, dimensions);
+}
+
+void GeometryParser::parseChunk(const Chunk& chunk, float* pointData, uint32_t* indexData, int dimensions)
+{
+	parseChunkImpl(chunk, pointData, indexData, dimensions);
+}
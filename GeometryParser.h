@@ -0,0 +1,116 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "MeshBounds.h"
+
+/**
+ * Parser for our ad-hoc text geometry format, working on an in-memory buffer.
+ *
+ * The format is line based: `[points]` and `[indices]` lines switch section,
+ * lines starting with `#` and blank lines are ignored, a point line holds
+ * `dimensions + 3` floats (position then color) and an index line holds the 3
+ * corners of a triangle. Both LF and CRLF line endings are accepted.
+ *
+ * Malformed input is handled differently from the former std::istream based
+ * loader, deliberately, so that a value never depends on the line before:
+ *  - lines holding only whitespace are ignored, where the old loader added
+ *    a full line of copies of the last value read;
+ *  - missing or malformed values are read as 0, where it repeated the last
+ *    value read;
+ *  - indices that do not fit in the requested index type are read as 0,
+ *    where it clamped them to the largest index (e.g. 65535).
+ * Well-formed files parse the same.
+ */
+class GeometryParser
+{
+public:
+	enum class Section {
+		None,
+		Points,
+		Indices,
+	};
+
+	/**
+	 * A range of whole lines of the file. Chunks are first scanned
+	 * independently, which tells how many data lines they hold and which
+	 * section is active at their end, then resolved in order to know which
+	 * section they start in and where their values go in the output.
+	 */
+	struct Chunk {
+		const char* begin = nullptr;
+		const char* end = nullptr;
+
+		// Filled by the scan
+		size_t leadingDataLines = 0; // data lines before the first header of the chunk
+		size_t pointLines = 0;       // point lines after the first header
+		size_t indexLines = 0;       // index lines after the first header
+		Section lastHeader = Section::None;
+
+		// Filled when resolving chunks in order, in number of values
+		Section startSection = Section::None;
+		size_t pointOffset = 0;
+		size_t pointCount = 0;
+		size_t indexOffset = 0;
+		size_t indexCount = 0;
+	};
+
+	/**
+	 * Parse the text in [begin, end) into `pointData` and `indexData`, which
+	 * are cleared first then sized from a counting pass, so that the
+	 * only allocations are the two output buffers.
+	 *
+	 * The buffer is split at line boundaries into up to `threadCount` chunks
+	 * that are scanned then parsed on worker threads, each writing its own
+	 * slice of the output. The result is bit-identical whatever the number of
+	 * threads. A `threadCount` of 0 picks defaultThreadCount().
+	 *
+	 * If `bounds` is given, each worker also reduces the points of its chunk
+	 * right after parsing them, and the result is their overall bounds.
+	 */
+	static void parse(
+		const char* begin,
+		const char* end,
+		std::vector<float>& pointData,
+		std::vector<uint16_t>& indexData,
+		int dimensions,
+		unsigned threadCount = 1,
+		MeshBounds* bounds = nullptr
+	);
+	static void parse(
+		const char* begin,
+		const char* end,
+		std::vector<float>& pointData,
+		std::vector<uint32_t>& indexData,
+		int dimensions,
+		unsigned threadCount = 1,
+		MeshBounds* bounds = nullptr
+	);
+
+	/**
+	 * Split [begin, end) into at most `chunkCount` chunks of similar size,
+	 * cutting only right after a '\n', then scan them on up to `threadCount`
+	 * threads and resolve their sections and output ranges.
+	 */
+	static std::vector<Chunk> split(
+		const char* begin,
+		const char* end,
+		size_t chunkCount,
+		int dimensions,
+		unsigned threadCount = 1
+	);
+
+	/**
+	 * Parse a chunk returned by split(). `pointData` and `indexData` must have
+	 * room for `chunk.pointCount` and `chunk.indexCount` values.
+	 */
+	static void parseChunk(const Chunk& chunk, float* pointData, uint16_t* indexData, int dimensions);
+	static void parseChunk(const Chunk& chunk, float* pointData, uint32_t* indexData, int dimensions);
+
+	/**
+	 * Number of threads worth using for a buffer of `size` bytes: one per
+	 * hardware thread, but never less than about a megabyte per thread.
+	 * Always 1 when threads are not available (Emscripten without pthreads).
+	 */
+	static unsigned defaultThreadCount(size_t size);
+};
@@ -0,0 +1,165 @@
+#include "GeometryStreamer.h"
+
+#include <algorithm>
+
+GeometryStreamer::~GeometryStreamer()
+{
+#ifdef GEOMETRY_STREAMER_THREADS
+	if (m_producer.joinable()) {
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_stopping = true;
+		}
+		m_slotConsumed.notify_one();
+		m_producer.join();
+	}
+#endif // GEOMETRY_STREAMER_THREADS
+}
+
+bool GeometryStreamer::open(const std::filesystem::path& path, int dimensions, size_t chunkSize)
+{
+	m_chunks.clear();
+	m_pointCount = 0;
+	m_indexCount = 0;
+	m_dimensions = dimensions;
+	if (!VertexLayout::floatLayout(dimensions, m_vertexLayout)) return false;
+	if (!m_file.open(path)) return false;
+
+	const char* begin = reinterpret_cast<const char*>(m_file.data());
+	const char* end = begin + m_file.size();
+	size_t chunkCount = (m_file.size() + chunkSize - 1) / std::max<size_t>(chunkSize, 1);
+	m_chunks = GeometryParser::split(begin, end, chunkCount, dimensions, GeometryParser::defaultThreadCount(m_file.size()));
+
+	if (!m_chunks.empty()) {
+		m_pointCount = m_chunks.back().pointOffset + m_chunks.back().pointCount;
+		m_indexCount = m_chunks.back().indexOffset + m_chunks.back().indexCount;
+	}
+	size_t vertexCount = m_pointCount / (static_cast<size_t>(dimensions) + 3);
+	m_indexFormat = Geometry::indexFormatFor(vertexCount);
+	return true;
+}
+
+size_t GeometryStreamer::indexDataSize() const
+{
+	return Geometry::indexDataSize(m_indexFormat, m_indexCount);
+}
+
+void GeometryStreamer::stream(const std::function<void(const Batch&)>& consume, size_t ringSize)
+{
+	start(ringSize);
+	while (!poll(consume, true)) {}
+}
+
+void GeometryStreamer::start(size_t ringSize)
+{
+	if (m_chunks.empty()) return;
+	ringSize = std::max<size_t>(ringSize, 1);
+
+	// Every slot is sized once for the largest chunk (+1 index carried over
+	// from the previous chunk, +1 padding index)
+	size_t maxPointCount = 0;
+	size_t maxIndexCount = 0;
+	for (const GeometryParser::Chunk& chunk : m_chunks) {
+		maxPointCount = std::max(maxPointCount, chunk.pointCount);
+		maxIndexCount = std::max(maxIndexCount, chunk.indexCount);
+	}
+	m_slots.resize(std::min(ringSize, m_chunks.size()));
+	for (Slot& slot : m_slots) {
+		slot.points.resize(maxPointCount);
+		if (m_indexFormat == WGPUIndexFormat_Uint32) slot.indices32.resize(maxIndexCount);
+		else slot.indices16.resize(maxIndexCount + 2);
+	}
+
+#ifdef GEOMETRY_STREAMER_THREADS
+	m_producer = std::thread([this]() {
+		for (size_t k = 0; k < m_chunks.size(); ++k) {
+			{
+				// Wait for the slot to be free
+				std::unique_lock<std::mutex> lock(m_mutex);
+				m_slotConsumed.wait(lock, [this]() { return m_stopping || m_producedCount - m_consumedCount < m_slots.size(); });
+				if (m_stopping) return;
+			}
+			produce(k);
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				++m_producedCount;
+			}
+			m_slotProduced.notify_one();
+		}
+	});
+#endif // GEOMETRY_STREAMER_THREADS
+}
+
+bool GeometryStreamer::poll(const std::function<void(const Batch&)>& consume, bool wait)
+{
+	if (isFinished()) return true;
+
+#ifdef GEOMETRY_STREAMER_THREADS
+	// Only the batches that are ready now, the producer keeps going while
+	// they are consumed
+	size_t producedCount;
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		if (wait) {
+			m_slotProduced.wait(lock, [this]() { return m_producedCount > m_consumedCount; });
+		}
+		producedCount = m_producedCount;
+	}
+	while (m_consumedCount < producedCount) {
+		consume(m_slots[m_consumedCount % m_slots.size()].batch);
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			++m_consumedCount;
+		}
+		m_slotConsumed.notify_one();
+	}
+	if (isFinished()) {
+		m_producer.join();
+	}
+#else // GEOMETRY_STREAMER_THREADS
+	(void)wait;
+	produce(m_producedCount++);
+	consume(m_slots[m_consumedCount++ % m_slots.size()].batch);
+#endif // GEOMETRY_STREAMER_THREADS
+	return isFinished();
+}
+
+void GeometryStreamer::produce(size_t k)
+{
+	const GeometryParser::Chunk& chunk = m_chunks[k];
+	Slot& slot = m_slots[k % m_slots.size()];
+	Batch& batch = slot.batch;
+
+	size_t indexCount = 0;
+	if (m_indexFormat == WGPUIndexFormat_Uint32) {
+		GeometryParser::parseChunk(chunk, slot.points.data(), slot.indices32.data(), m_dimensions);
+		indexCount = chunk.indexCount;
+		batch.indexData = slot.indices32.data();
+	}
+	else {
+		if (m_hasCarry) slot.indices16[indexCount++] = m_carry;
+		GeometryParser::parseChunk(chunk, slot.points.data(), slot.indices16.data() + indexCount, m_dimensions);
+		indexCount += chunk.indexCount;
+
+		m_hasCarry = false;
+		if (indexCount % 2 != 0) {
+			if (k + 1 < m_chunks.size()) {
+				m_carry = slot.indices16[--indexCount];
+				m_hasCarry = true;
+			}
+			else {
+				slot.indices16[indexCount++] = 0;
+			}
+		}
+		batch.indexData = slot.indices16.data();
+	}
+
+	batch.pointData = slot.points.data();
+	batch.pointCount = chunk.pointCount;
+	batch.pointOffset = chunk.pointOffset * sizeof(float);
+	batch.indexCount = indexCount;
+	batch.indexOffset = m_indexOffset;
+	batch.indexFormat = m_indexFormat;
+	batch.bounds = MeshBounds::fromPoints(slot.points.data(), chunk.pointCount / (static_cast<size_t>(m_dimensions) + 3), m_dimensions);
+	m_indexOffset += batch.indexDataSize();
+}
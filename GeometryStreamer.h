@@ -0,0 +1,148 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <vector>
+#include <webgpu/webgpu.h>
+#include "Geometry.h"
+#include "GeometryParser.h"
+#include "MappedFile.h"
+#include "MeshBounds.h"
+
+#if !defined(__EMSCRIPTEN__) || defined(__EMSCRIPTEN_PTHREADS__)
+#  define GEOMETRY_STREAMER_THREADS
+#  include <condition_variable>
+#  include <mutex>
+#  include <thread>
+#endif
+
+/**
+ * Parse a text geometry file chunk by chunk and hand each parsed chunk over
+ * as soon as it is ready, instead of building whole-file vectors.
+ *
+ * Chunks are parsed on a worker thread into a bounded ring of staging slots
+ * while the calling thread consumes them (typically with wgpuQueueWriteBuffer),
+ * so parsing and upload overlap and peak CPU memory only depends on the
+ * chunk size and ring size, not on the size of the mesh.
+ *
+ * Batches are either all consumed at once with stream(), or a few at a time
+ * with start() then poll(), e.g. once per frame so that loading never
+ * blocks the render thread for long. Without thread support (Emscripten
+ * without pthreads), each poll() parses a single chunk itself.
+ */
+class GeometryStreamer
+{
+public:
+	// Bytes of text parsed per chunk
+	static constexpr size_t DefaultChunkSize = 4 << 20;
+	// Number of parsed chunks that can wait for upload at once
+	static constexpr size_t DefaultRingSize = 3;
+
+	/**
+	 * A parsed chunk. Offsets are in bytes within the destination buffers and,
+	 * like sizes, are multiples of 4 as required by wgpuQueueWriteBuffer. To
+	 * keep them so with 16-bit indices, an odd trailing index is carried over
+	 * to the next batch and the last batch is padded with a 0 index.
+	 */
+	struct Batch {
+		const float* pointData = nullptr;
+		size_t pointCount = 0;
+		uint64_t pointOffset = 0;
+		const void* indexData = nullptr;
+		size_t indexCount = 0; // including carry and padding
+		uint64_t indexOffset = 0;
+		WGPUIndexFormat indexFormat = WGPUIndexFormat_Uint16;
+		// Bounds of the points of this batch, computed on the parsing thread
+		MeshBounds bounds;
+
+		size_t pointDataSize() const { return pointCount * sizeof(float); }
+		size_t indexDataSize() const { return indexCount * (indexFormat == WGPUIndexFormat_Uint32 ? sizeof(uint32_t) : sizeof(uint16_t)); }
+	};
+
+	GeometryStreamer() = default;
+	// Stop parsing, dropping the batches that were not consumed
+	~GeometryStreamer();
+
+	GeometryStreamer(const GeometryStreamer&) = delete;
+	GeometryStreamer& operator=(const GeometryStreamer&) = delete;
+
+	/**
+	 * Map the file and count its points and indices, so that destination
+	 * buffers can be created before streaming. The index format is chosen
+	 * from the vertex count (see Geometry::indexFormatFor()). Fails if the
+	 * file cannot be read or `dimensions` is not supported, which is
+	 * reported by VertexLayout::floatLayout().
+	 */
+	bool open(const std::filesystem::path& path, int dimensions, size_t chunkSize = DefaultChunkSize);
+
+	// Layout of the streamed points (see VertexLayout::floatLayout())
+	const VertexLayout& vertexLayout() const { return m_vertexLayout; }
+
+	// Number of floats in the point data (not the number of vertices)
+	size_t pointCount() const { return m_pointCount; }
+	size_t pointDataSize() const { return m_pointCount * sizeof(float); }
+	// Number of indices, excluding padding
+	size_t indexCount() const { return m_indexCount; }
+	WGPUIndexFormat indexFormat() const { return m_indexFormat; }
+	// Size in bytes of the index data, rounded up to a multiple of 4
+	size_t indexDataSize() const;
+
+	/**
+	 * Parse all chunks and call `consume` for each of them, in file order and
+	 * on the calling thread. The batch data is only valid during the call.
+	 */
+	void stream(const std::function<void(const Batch&)>& consume, size_t ringSize = DefaultRingSize);
+
+	/**
+	 * Start parsing chunks in the background, into a ring of `ringSize`
+	 * staging slots. Call once, after open().
+	 */
+	void start(size_t ringSize = DefaultRingSize);
+
+	/**
+	 * Call `consume` for each batch parsed since the last call, like
+	 * stream() does. If `wait` is set and none is ready yet, wait for the
+	 * next one. Return true once every batch was consumed.
+	 */
+	bool poll(const std::function<void(const Batch&)>& consume, bool wait = false);
+
+	bool isFinished() const { return m_consumedCount == m_chunks.size(); }
+
+private:
+	struct Slot {
+		std::vector<float> points;
+		// Only the vector matching the index format is used
+		std::vector<uint16_t> indices16;
+		std::vector<uint32_t> indices32;
+		Batch batch;
+	};
+
+	// Parse chunk `k` into its slot. Runs strictly in chunk order, which
+	// the 16-bit index carry relies on.
+	void produce(size_t k);
+
+	MappedFile m_file;
+	std::vector<GeometryParser::Chunk> m_chunks;
+	int m_dimensions = 0;
+	VertexLayout m_vertexLayout;
+	size_t m_pointCount = 0;
+	size_t m_indexCount = 0;
+	WGPUIndexFormat m_indexFormat = WGPUIndexFormat_Uint16;
+
+	std::vector<Slot> m_slots;
+	// Only touched by the producer
+	bool m_hasCarry = false;
+	uint16_t m_carry = 0;
+	uint64_t m_indexOffset = 0;
+	// Number of batches parsed and consumed so far
+	size_t m_producedCount = 0;
+	size_t m_consumedCount = 0;
+#ifdef GEOMETRY_STREAMER_THREADS
+	std::thread m_producer;
+	std::mutex m_mutex;
+	std::condition_variable m_slotProduced;
+	std::condition_variable m_slotConsumed;
+	bool m_stopping = false;
+#endif
+};
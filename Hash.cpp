@@ -0,0 +1,164 @@
+#include "Hash.h"
+
+#include <cstring>
+
+namespace
+{
+	constexpr uint64_t Prime1 = 0x9E3779B185EBCA87ULL;
+	constexpr uint64_t Prime2 = 0xC2B2AE3D27D4EB4FULL;
+	constexpr uint64_t Prime3 = 0x165667B19E3779F9ULL;
+	constexpr uint64_t Prime4 = 0x85EBCA77C2B2AE63ULL;
+	constexpr uint64_t Prime5 = 0x27D4EB2F165667C5ULL;
+
+	uint64_t rotateLeft(uint64_t value, int bits)
+	{
+		return (value << bits) | (value >> (64 - bits));
+	}
+
+	uint64_t read64(const uint8_t* data)
+	{
+		uint64_t value;
+		std::memcpy(&value, data, sizeof(value));
+		return value;
+	}
+
+	uint32_t read32(const uint8_t* data)
+	{
+		uint32_t value;
+		std::memcpy(&value, data, sizeof(value));
+		return value;
+	}
+
+	uint64_t round(uint64_t accumulator, uint64_t input)
+	{
+		accumulator += input * Prime2;
+		accumulator = rotateLeft(accumulator, 31);
+		return accumulator * Prime1;
+	}
+
+	uint64_t mergeRound(uint64_t hash, uint64_t accumulator)
+	{
+		hash ^= round(0, accumulator);
+		return hash * Prime1 + Prime4;
+	}
+
+	// Consume as many 32-byte stripes as possible, return the number of bytes read
+	size_t consumeStripes(uint64_t accumulators[4], const uint8_t* data, size_t size)
+	{
+		const uint8_t* p = data;
+		const uint8_t* end = data + size;
+		uint64_t v0 = accumulators[0], v1 = accumulators[1], v2 = accumulators[2], v3 = accumulators[3];
+		while (end - p >= 32) {
+			v0 = round(v0, read64(p));
+			v1 = round(v1, read64(p + 8));
+			v2 = round(v2, read64(p + 16));
+			v3 = round(v3, read64(p + 24));
+			p += 32;
+		}
+		accumulators[0] = v0; accumulators[1] = v1; accumulators[2] = v2; accumulators[3] = v3;
+		return static_cast<size_t>(p - data);
+	}
+}
+
+Hasher::Hasher(uint64_t seed)
+	: m_seed(seed)
+{
+	m_accumulators[0] = seed + Prime1 + Prime2;
+	m_accumulators[1] = seed + Prime2;
+	m_accumulators[2] = seed;
+	m_accumulators[3] = seed - Prime1;
+}
+
+void Hasher::update(const void* data, size_t size)
+{
+	if (size == 0) return;
+	const uint8_t* p = static_cast<const uint8_t*>(data);
+	m_totalSize += size;
+
+	// Complete the stripe started by a previous call first
+	if (m_bufferSize > 0) {
+		size_t fill = sizeof(m_buffer) - m_bufferSize;
+		if (size < fill) {
+			std::memcpy(m_buffer + m_bufferSize, p, size);
+			m_bufferSize += size;
+			return;
+		}
+		std::memcpy(m_buffer + m_bufferSize, p, fill);
+		consumeStripes(m_accumulators, m_buffer, sizeof(m_buffer));
+		m_bufferSize = 0;
+		p += fill;
+		size -= fill;
+	}
+
+	size_t consumed = consumeStripes(m_accumulators, p, size);
+	m_bufferSize = size - consumed;
+	std::memcpy(m_buffer, p + consumed, m_bufferSize);
+}
+
+void Hasher::updateString(const std::string& value)
+{
+	// Prefix with the length so that consecutive strings cannot be confused
+	updateValue(static_cast<uint64_t>(value.size()));
+	update(value.data(), value.size());
+}
+
+uint64_t Hasher::digest() const
+{
+	uint64_t hash;
+	if (m_totalSize >= 32) {
+		const uint64_t* v = m_accumulators;
+		hash = rotateLeft(v[0], 1) + rotateLeft(v[1], 7) + rotateLeft(v[2], 12) + rotateLeft(v[3], 18);
+		hash = mergeRound(hash, v[0]);
+		hash = mergeRound(hash, v[1]);
+		hash = mergeRound(hash, v[2]);
+		hash = mergeRound(hash, v[3]);
+	}
+	else {
+		hash = m_seed + Prime5;
+	}
+	hash += m_totalSize;
+
+	const uint8_t* p = m_buffer;
+	const uint8_t* end = m_buffer + m_bufferSize;
+	while (end - p >= 8) {
+		hash ^= round(0, read64(p));
+		hash = rotateLeft(hash, 27) * Prime1 + Prime4;
+		p += 8;
+	}
+	if (end - p >= 4) {
+		hash ^= static_cast<uint64_t>(read32(p)) * Prime1;
+		hash = rotateLeft(hash, 23) * Prime2 + Prime3;
+		p += 4;
+	}
+	while (p < end) {
+		hash ^= static_cast<uint64_t>(*p) * Prime5;
+		hash = rotateLeft(hash, 11) * Prime1;
+		++p;
+	}
+
+	// Final avalanche
+	hash ^= hash >> 33;
+	hash *= Prime2;
+	hash ^= hash >> 29;
+	hash *= Prime3;
+	hash ^= hash >> 32;
+	return hash;
+}
+
+uint64_t Hasher::hash(const void* data, size_t size, uint64_t seed)
+{
+	Hasher hasher(seed);
+	hasher.update(data, size);
+	return hasher.digest();
+}
+
+std::string Hasher::toHex(uint64_t hash)
+{
+	static const char digits[] = "0123456789abcdef";
+	std::string hex(16, '0');
+	for (int i = 15; i >= 0; --i) {
+		hex[i] = digits[hash & 0xF];
+		hash >>= 4;
+	}
+	return hex;
+}
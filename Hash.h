@@ -0,0 +1,50 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+/**
+ * Streaming 64-bit non-cryptographic hash (XXH64). Fast enough to hash whole
+ * source files on every load, and stable across runs and machines of the same
+ * endianness, so that it can name content-addressed cache entries.
+ */
+class Hasher
+{
+public:
+	explicit Hasher(uint64_t seed = 0);
+
+	void update(const void* data, size_t size);
+
+	/**
+	 * Hash the bytes of a plain value. Padding bytes must be zero-initialized.
+	 */
+	template <typename T>
+	void updateValue(const T& value)
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "only plain values can be hashed as bytes");
+		update(&value, sizeof(T));
+	}
+
+	void updateString(const std::string& value);
+
+	/**
+	 * Hash of everything passed to update() so far. More data may be added
+	 * afterwards.
+	 */
+	uint64_t digest() const;
+
+	static uint64_t hash(const void* data, size_t size, uint64_t seed = 0);
+
+	/**
+	 * Fixed width, lower case hexadecimal representation of a hash.
+	 */
+	static std::string toHex(uint64_t hash);
+
+private:
+	uint64_t m_seed;
+	uint64_t m_accumulators[4];
+	uint8_t m_buffer[32];
+	size_t m_bufferSize = 0;
+	uint64_t m_totalSize = 0;
+};
@@ -0,0 +1,154 @@
+#include "Lz4.h"
+
+#include <cstring>
+
+namespace
+{
+	constexpr size_t MinMatch = 4;
+	// The last 5 bytes are always literals, and the last match starts at
+	// least 12 bytes before the end of the block
+	constexpr size_t LastLiterals = 5;
+	constexpr size_t MatchStartLimit = 12;
+	constexpr size_t MaxOffset = 65535;
+	constexpr int HashBits = 16;
+
+	uint32_t read32(const uint8_t* p)
+	{
+		uint32_t value;
+		std::memcpy(&value, p, sizeof(value));
+		return value;
+	}
+
+	uint32_t hashSequence(uint32_t sequence)
+	{
+		return (sequence * 2654435761u) >> (32 - HashBits);
+	}
+
+	void writeLength(std::vector<uint8_t>& dst, size_t length)
+	{
+		for (; length >= 255; length -= 255) dst.push_back(255);
+		dst.push_back(static_cast<uint8_t>(length));
+	}
+
+	void writeSequence(std::vector<uint8_t>& dst, const uint8_t* literals, size_t literalLength, size_t offset, size_t matchLength)
+	{
+		size_t matchCode = matchLength - MinMatch;
+		uint8_t token = static_cast<uint8_t>((literalLength < 15 ? literalLength : 15) << 4);
+		token |= static_cast<uint8_t>(matchCode < 15 ? matchCode : 15);
+		dst.push_back(token);
+		if (literalLength >= 15) writeLength(dst, literalLength - 15);
+		dst.insert(dst.end(), literals, literals + literalLength);
+		dst.push_back(static_cast<uint8_t>(offset & 0xFF));
+		dst.push_back(static_cast<uint8_t>(offset >> 8));
+		if (matchCode >= 15) writeLength(dst, matchCode - 15);
+	}
+
+	void writeLastLiterals(std::vector<uint8_t>& dst, const uint8_t* literals, size_t literalLength)
+	{
+		dst.push_back(static_cast<uint8_t>((literalLength < 15 ? literalLength : 15) << 4));
+		if (literalLength >= 15) writeLength(dst, literalLength - 15);
+		dst.insert(dst.end(), literals, literals + literalLength);
+	}
+
+	bool readLength(const uint8_t*& ip, const uint8_t* end, size_t& length)
+	{
+		uint8_t byte;
+		do {
+			if (ip >= end) return false;
+			byte = *ip++;
+			length += byte;
+		} while (byte == 255);
+		return true;
+	}
+}
+
+size_t Lz4::compressBound(size_t size)
+{
+	return size + size / 255 + 16;
+}
+
+std::vector<uint8_t> Lz4::compress(const uint8_t* data, size_t size)
+{
+	std::vector<uint8_t> dst;
+	dst.reserve(compressBound(size));
+
+	size_t anchor = 0;
+	if (size > MatchStartLimit) {
+		// Positions + 1 of the last occurrence of each hashed 4-byte sequence
+		std::vector<uint32_t> table(size_t(1) << HashBits, 0);
+		const size_t matchEnd = size - LastLiterals;
+		const size_t lastMatchStart = size - MatchStartLimit;
+
+		size_t i = 0;
+		size_t misses = 0;
+		while (i <= lastMatchStart) {
+			uint32_t sequence = read32(data + i);
+			uint32_t& slot = table[hashSequence(sequence)];
+			size_t candidate = slot;
+			slot = static_cast<uint32_t>(i + 1);
+			if (candidate == 0 || i - (candidate - 1) > MaxOffset || read32(data + candidate - 1) != sequence) {
+				// Skip faster through incompressible data
+				i += 1 + (misses++ >> 6);
+				continue;
+			}
+			misses = 0;
+
+			size_t match = candidate - 1;
+			while (i > anchor && match > 0 && data[i - 1] == data[match - 1]) {
+				--i;
+				--match;
+			}
+			size_t length = MinMatch;
+			while (i + length < matchEnd && data[i + length] == data[match + length]) ++length;
+
+			writeSequence(dst, data + anchor, i - anchor, i - match, length);
+			i += length;
+			anchor = i;
+		}
+	}
+	writeLastLiterals(dst, data + anchor, size - anchor);
+	return dst;
+}
+
+bool Lz4::decompress(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstSize)
+{
+	const uint8_t* ip = src;
+	const uint8_t* const srcEnd = src + srcSize;
+	uint8_t* op = dst;
+	uint8_t* const dstEnd = dst + dstSize;
+
+	while (ip < srcEnd) {
+		const uint8_t token = *ip++;
+
+		size_t literalLength = token >> 4;
+		if (literalLength == 15 && !readLength(ip, srcEnd, literalLength)) return false;
+		if (literalLength > static_cast<size_t>(srcEnd - ip) || literalLength > static_cast<size_t>(dstEnd - op)) return false;
+		if (literalLength > 0) std::memcpy(op, ip, literalLength);
+		op += literalLength;
+		ip += literalLength;
+
+		// The last sequence only has literals
+		if (ip == srcEnd) break;
+
+		if (srcEnd - ip < 2) return false;
+		size_t offset = ip[0] | (static_cast<size_t>(ip[1]) << 8);
+		ip += 2;
+		if (offset == 0 || offset > static_cast<size_t>(op - dst)) return false;
+
+		size_t matchLength = token & 15;
+		if (matchLength == 15 && !readLength(ip, srcEnd, matchLength)) return false;
+		matchLength += MinMatch;
+		if (matchLength > static_cast<size_t>(dstEnd - op)) return false;
+
+		const uint8_t* match = op - offset;
+		if (offset >= matchLength) {
+			std::memcpy(op, match, matchLength);
+		}
+		else {
+			// Overlapping copy, which repeats the last `offset` bytes
+			for (size_t k = 0; k < matchLength; ++k) op[k] = match[k];
+		}
+		op += matchLength;
+	}
+	return op == dstEnd;
+}
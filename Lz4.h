@@ -0,0 +1,26 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Compression in the LZ4 block format: fast to decompress, so that packed
+ * resources do not noticeably slow down loading. The compressor is a simple
+ * greedy one; the block is not framed, sizes are stored by the caller.
+ */
+class Lz4
+{
+public:
+	/**
+	 * Worst case size of the compressed block of `size` bytes.
+	 */
+	static size_t compressBound(size_t size);
+
+	static std::vector<uint8_t> compress(const uint8_t* data, size_t size);
+
+	/**
+	 * Decompress a block into exactly `dstSize` bytes. Return false if the
+	 * block is malformed or does not decompress to `dstSize` bytes.
+	 */
+	static bool decompress(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstSize);
+};
@@ -0,0 +1,138 @@
+#include "MappedFile.h"
+
+#include <utility>
+
+#ifdef _WIN32
+#  ifndef NOMINMAX
+#    define NOMINMAX
+#  endif
+#  include <windows.h>
+#else
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#endif
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+{
+	*this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+	if (this != &other)
+	{
+		close();
+		m_data = std::exchange(other.m_data, nullptr);
+		m_size = std::exchange(other.m_size, 0);
+		m_isOpen = std::exchange(other.m_isOpen, false);
+#ifdef _WIN32
+		m_fileHandle = std::exchange(other.m_fileHandle, nullptr);
+		m_mappingHandle = std::exchange(other.m_mappingHandle, nullptr);
+#endif
+	}
+	return *this;
+}
+
+#ifdef _WIN32
+
+bool MappedFile::open(const std::filesystem::path& path)
+{
+	close();
+
+	HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE) return false;
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize))
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	m_fileHandle = file;
+	m_size = static_cast<size_t>(fileSize.QuadPart);
+	m_isOpen = true;
+	// A zero-sized file cannot be mapped, but it is still a valid (empty) file
+	if (m_size == 0) return true;
+
+	HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mapping == nullptr)
+	{
+		close();
+		return false;
+	}
+	m_mappingHandle = mapping;
+
+	m_data = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+	if (m_data == nullptr)
+	{
+		close();
+		return false;
+	}
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (m_data) UnmapViewOfFile(m_data);
+	if (m_mappingHandle) CloseHandle(m_mappingHandle);
+	if (m_fileHandle) CloseHandle(m_fileHandle);
+	m_data = nullptr;
+	m_mappingHandle = nullptr;
+	m_fileHandle = nullptr;
+	m_size = 0;
+	m_isOpen = false;
+}
+
+#else // _WIN32
+
+bool MappedFile::open(const std::filesystem::path& path)
+{
+	close();
+
+	int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0) return false;
+
+	struct stat info;
+	if (fstat(fd, &info) != 0)
+	{
+		::close(fd);
+		return false;
+	}
+
+	m_size = static_cast<size_t>(info.st_size);
+	m_isOpen = true;
+	if (m_size > 0)
+	{
+		void* address = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (address == MAP_FAILED)
+		{
+			::close(fd);
+			m_size = 0;
+			m_isOpen = false;
+			return false;
+		}
+		m_data = static_cast<const uint8_t*>(address);
+	}
+
+	// The mapping stays valid after the descriptor is closed
+	::close(fd);
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (m_data) munmap(const_cast<uint8_t*>(m_data), m_size);
+	m_data = nullptr;
+	m_size = 0;
+	m_isOpen = false;
+}
+
+#endif // _WIN32
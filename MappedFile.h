@@ -0,0 +1,41 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+
+/**
+ * Read-only memory mapping of a whole file. The mapping lives as long as the
+ * object, so pointers returned by data() must not outlive it.
+ */
+class MappedFile
+{
+public:
+	MappedFile() = default;
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+	MappedFile(MappedFile&& other) noexcept;
+	MappedFile& operator=(MappedFile&& other) noexcept;
+
+	/**
+	 * Map the file at `path`, closing any previously mapped file first.
+	 * An empty file opens successfully with a null data() and a size() of 0.
+	 */
+	bool open(const std::filesystem::path& path);
+
+	void close();
+
+	bool isOpen() const { return m_isOpen; }
+	const uint8_t* data() const { return m_data; }
+	size_t size() const { return m_size; }
+
+private:
+	const uint8_t* m_data = nullptr;
+	size_t m_size = 0;
+	bool m_isOpen = false;
+#ifdef _WIN32
+	void* m_fileHandle = nullptr;
+	void* m_mappingHandle = nullptr;
+#endif
+};
@@ -0,0 +1,80 @@
+#include "Mat4.h"
+
+#include <cmath>
+
+Mat4 Mat4::translation(float x, float y, float z)
+{
+	Mat4 result;
+	result.at(0, 3) = x;
+	result.at(1, 3) = y;
+	result.at(2, 3) = z;
+	return result;
+}
+
+Mat4 Mat4::scale(float s)
+{
+	Mat4 result;
+	result.at(0, 0) = s;
+	result.at(1, 1) = s;
+	result.at(2, 2) = s;
+	return result;
+}
+
+Mat4 Mat4::rotationX(float angle)
+{
+	const float c = std::cos(angle), s = std::sin(angle);
+	Mat4 result;
+	result.at(1, 1) = c;
+	result.at(1, 2) = -s;
+	result.at(2, 1) = s;
+	result.at(2, 2) = c;
+	return result;
+}
+
+Mat4 Mat4::rotationZ(float angle)
+{
+	const float c = std::cos(angle), s = std::sin(angle);
+	Mat4 result;
+	result.at(0, 0) = c;
+	result.at(0, 1) = -s;
+	result.at(1, 0) = s;
+	result.at(1, 1) = c;
+	return result;
+}
+
+Mat4 Mat4::perspective(float focalLength, float aspectRatio, float near, float far)
+{
+	Mat4 result;
+	result.at(0, 0) = focalLength / aspectRatio;
+	result.at(1, 1) = focalLength;
+	result.at(2, 2) = far / (far - near);
+	result.at(2, 3) = -far * near / (far - near);
+	// w = z, for the perspective division
+	result.at(3, 2) = 1.0f;
+	result.at(3, 3) = 0.0f;
+	return result;
+}
+
+Mat4 Mat4::operator*(const Mat4& other) const
+{
+	Mat4 result;
+	for (int column = 0; column < 4; ++column) {
+		for (int row = 0; row < 4; ++row) {
+			float sum = 0.0f;
+			for (int k = 0; k < 4; ++k) {
+				sum += at(row, k) * other.at(k, column);
+			}
+			result.at(row, column) = sum;
+		}
+	}
+	return result;
+}
+
+std::array<float, 3> Mat4::transformPoint(const std::array<float, 3>& p) const
+{
+	std::array<float, 3> result;
+	for (int row = 0; row < 3; ++row) {
+		result[row] = at(row, 0) * p[0] + at(row, 1) * p[1] + at(row, 2) * p[2] + at(row, 3);
+	}
+	return result;
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <array>
+
+/**
+ * 4x4 float matrix, stored column by column like mat4x4f in WGSL, so that it
+ * can be copied to a uniform buffer as is. Points are column vectors:
+ * `a * b` applies `b` first.
+ */
+struct Mat4
+{
+	std::array<float, 16> m = {
+		1.0f, 0.0f, 0.0f, 0.0f,
+		0.0f, 1.0f, 0.0f, 0.0f,
+		0.0f, 0.0f, 1.0f, 0.0f,
+		0.0f, 0.0f, 0.0f, 1.0f,
+	};
+
+	float& at(int row, int column) { return m[column * 4 + row]; }
+	float at(int row, int column) const { return m[column * 4 + row]; }
+
+	static Mat4 identity() { return Mat4(); }
+	static Mat4 translation(float x, float y, float z);
+	static Mat4 scale(float s);
+	// Counter-clockwise when looking down the axis, from positive to 0
+	static Mat4 rotationX(float angle);
+	static Mat4 rotationZ(float angle);
+
+	/**
+	 * Perspective projection of a view space looking towards +Z with Y up,
+	 * to WebGPU clip space (depth from 0 at `near` to 1 at `far`).
+	 * `focalLength` is 1 / tan(vertical field of view / 2).
+	 */
+	static Mat4 perspective(float focalLength, float aspectRatio, float near, float far);
+
+	Mat4 operator*(const Mat4& other) const;
+
+	/**
+	 * Apply to a point, assuming the last row is (0, 0, 0, 1).
+	 */
+	std::array<float, 3> transformPoint(const std::array<float, 3>& p) const;
+};
@@ -0,0 +1,127 @@
+#include "MeshBounds.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#  define MESH_BOUNDS_SSE
+#  include <xmmintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#  define MESH_BOUNDS_NEON
+#  include <arm_neon.h>
+#endif
+
+namespace
+{
+	/**
+	 * Per lane min and max of the first 4 floats of each point. With at least
+	 * 4 floats per point (1 coordinate and 3 color channels), loading them
+	 * never reads past the data; lanes beyond the position hold colors and
+	 * are dropped by the caller. Two pairs of accumulators hide the latency
+	 * of min/max.
+	 */
+	void reduce4(const float* points, size_t count, size_t stride, float* boxMin, float* boxMax)
+	{
+#if defined(MESH_BOUNDS_SSE)
+		__m128 min0 = _mm_loadu_ps(boxMin), min1 = min0;
+		__m128 max0 = _mm_loadu_ps(boxMax), max1 = max0;
+		size_t i = 0;
+		for (; i + 2 <= count; i += 2) {
+			__m128 p0 = _mm_loadu_ps(points + i * stride);
+			__m128 p1 = _mm_loadu_ps(points + (i + 1) * stride);
+			// minps and maxps return their second operand when either is NaN
+			min0 = _mm_min_ps(p0, min0);
+			max0 = _mm_max_ps(p0, max0);
+			min1 = _mm_min_ps(p1, min1);
+			max1 = _mm_max_ps(p1, max1);
+		}
+		if (i < count) {
+			__m128 p = _mm_loadu_ps(points + i * stride);
+			min0 = _mm_min_ps(p, min0);
+			max0 = _mm_max_ps(p, max0);
+		}
+		_mm_storeu_ps(boxMin, _mm_min_ps(min0, min1));
+		_mm_storeu_ps(boxMax, _mm_max_ps(max0, max1));
+#elif defined(MESH_BOUNDS_NEON)
+		float32x4_t min0 = vld1q_f32(boxMin), min1 = min0;
+		float32x4_t max0 = vld1q_f32(boxMax), max1 = max0;
+		size_t i = 0;
+		for (; i + 2 <= count; i += 2) {
+			float32x4_t p0 = vld1q_f32(points + i * stride);
+			float32x4_t p1 = vld1q_f32(points + (i + 1) * stride);
+			// vminnm and vmaxnm return the number when one operand is NaN
+			min0 = vminnmq_f32(min0, p0);
+			max0 = vmaxnmq_f32(max0, p0);
+			min1 = vminnmq_f32(min1, p1);
+			max1 = vmaxnmq_f32(max1, p1);
+		}
+		if (i < count) {
+			float32x4_t p = vld1q_f32(points + i * stride);
+			min0 = vminnmq_f32(min0, p);
+			max0 = vmaxnmq_f32(max0, p);
+		}
+		vst1q_f32(boxMin, vminnmq_f32(min0, min1));
+		vst1q_f32(boxMax, vmaxnmq_f32(max0, max1));
+#else
+		for (size_t i = 0; i < count; ++i) {
+			const float* p = points + i * stride;
+			for (int c = 0; c < 4; ++c) {
+				// Written so that a NaN coordinate keeps the accumulator
+				boxMin[c] = p[c] < boxMin[c] ? p[c] : boxMin[c];
+				boxMax[c] = p[c] > boxMax[c] ? p[c] : boxMax[c];
+			}
+		}
+#endif
+	}
+}
+
+MeshBounds MeshBounds::fromPoints(const float* pointData, size_t vertexCount, int dimensions)
+{
+	MeshBounds bounds;
+	const int axisCount = std::min(dimensions, 3);
+	if (vertexCount == 0 || axisCount <= 0) return bounds;
+
+	const size_t stride = static_cast<size_t>(dimensions) + 3;
+	float boxMin[4], boxMax[4];
+	std::fill(boxMin, boxMin + 4, std::numeric_limits<float>::max());
+	std::fill(boxMax, boxMax + 4, std::numeric_limits<float>::lowest());
+	reduce4(pointData, vertexCount, stride, boxMin, boxMax);
+	// An axis with only NaN coordinates keeps its initial values, and is
+	// flattened to 0 like missing axes. Only NaN coordinates at all leave
+	// the bounds empty.
+	bool hasValues = false;
+	for (int c = 0; c < 3; ++c) {
+		const bool valid = c < axisCount && boxMin[c] <= boxMax[c];
+		bounds.boxMin[c] = valid ? boxMin[c] : 0.0f;
+		bounds.boxMax[c] = valid ? boxMax[c] : 0.0f;
+		hasValues = hasValues || valid;
+	}
+	if (!hasValues) return MeshBounds();
+	bounds.updateSphere();
+	return bounds;
+}
+
+void MeshBounds::merge(const MeshBounds& other)
+{
+	if (other.empty()) return;
+	if (empty()) {
+		*this = other;
+		return;
+	}
+	for (int c = 0; c < 3; ++c) {
+		boxMin[c] = std::min(boxMin[c], other.boxMin[c]);
+		boxMax[c] = std::max(boxMax[c], other.boxMax[c]);
+	}
+	updateSphere();
+}
+
+void MeshBounds::updateSphere()
+{
+	float radius2 = 0.0f;
+	for (int c = 0; c < 3; ++c) {
+		center[c] = 0.5f * (boxMin[c] + boxMax[c]);
+		float halfExtent = 0.5f * (boxMax[c] - boxMin[c]);
+		radius2 += halfExtent * halfExtent;
+	}
+	radius = std::sqrt(radius2);
+}
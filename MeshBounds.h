@@ -0,0 +1,43 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <limits>
+
+/**
+ * Extent of a whole mesh in model space, computed while the points are
+ * parsed and stored along with the mesh (see Geometry and MeshCache), so
+ * that quantization, LOD selection and culling never need another pass over
+ * the vertices.
+ *
+ * Axes beyond the dimensions of the mesh are 0, like the positions the
+ * vertex shader sees. A default constructed MeshBounds is empty.
+ */
+struct MeshBounds
+{
+	std::array<float, 3> boxMin = { std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max() };
+	std::array<float, 3> boxMax = { std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest() };
+	// Bounding sphere, centered on the box. Its radius is the half diagonal
+	// of the box, which keeps it a single pass but makes it conservative.
+	std::array<float, 3> center = { 0.0f, 0.0f, 0.0f };
+	float radius = 0.0f;
+
+	bool empty() const { return boxMin[0] > boxMax[0]; }
+
+	/**
+	 * Bounds of `vertexCount` parsed points, interleaved as `dimensions`
+	 * position floats then 3 color floats. Uses a SIMD min/max reduction
+	 * when available (SSE, or NEON on AArch64), a scalar loop otherwise.
+	 * NaN coordinates are ignored, and an axis that has no other value is
+	 * treated as 0.
+	 */
+	static MeshBounds fromPoints(const float* pointData, size_t vertexCount, int dimensions);
+
+	/**
+	 * Grow to also enclose `other`, e.g. to combine the bounds of the chunks
+	 * of a file parsed in parallel.
+	 */
+	void merge(const MeshBounds& other);
+
+private:
+	void updateSphere();
+};
@@ -0,0 +1,230 @@
+#include "MeshCache.h"
+#include "AssetCache.h"
+#include "Geometry.h"
+#include "Hash.h"
+#include "MappedFile.h"
+
+#include <fstream>
+#include <iostream>
+#include <system_error>
+#include <utility>
+
+namespace
+{
+	uint64_t alignUp(uint64_t value, uint64_t alignment)
+	{
+		return (value + alignment - 1) / alignment * alignment;
+	}
+
+	// Whether `offset + size` fits in `limit`, without overflowing
+	bool fits(uint64_t offset, uint64_t size, uint64_t limit)
+	{
+		return size <= limit && offset <= limit - size;
+	}
+
+	// Same for `count` elements of `elementSize` bytes, which must not be 0
+	bool fitsArray(uint64_t offset, uint64_t count, uint64_t elementSize, uint64_t limit)
+	{
+		return count <= limit / elementSize && fits(offset, count * elementSize, limit);
+	}
+}
+
+MeshCache::Key MeshCache::makeKey(const void* sourceData, size_t sourceSize, int dimensions, GeometryProcessing processing)
+{
+	Key key;
+	key.sourceSize = sourceSize;
+	key.dimensions = dimensions;
+	key.processing = processing;
+
+	Hasher hasher;
+	hasher.update(sourceData, sourceSize);
+	hasher.updateValue(static_cast<uint64_t>(sourceSize));
+	hasher.updateValue(Version);
+	hasher.updateValue(static_cast<uint32_t>(dimensions));
+	hasher.updateValue(static_cast<uint32_t>(processing));
+	key.hash = hasher.digest();
+	return key;
+}
+
+bool MeshCache::makeKey(const std::filesystem::path& sourcePath, int dimensions, GeometryProcessing processing, Key& key)
+{
+	MappedFile file;
+	if (!file.open(sourcePath)) return false;
+	key = makeKey(file.data(), file.size(), dimensions, processing);
+	return true;
+}
+
+std::filesystem::path MeshCache::cachePathFor(const Key& key)
+{
+	return AssetCache::entryPath(key.hash, "meshcache");
+}
+
+bool MeshCache::read(const Key& key, Geometry& geometry)
+{
+	MappedFile file;
+	if (!file.open(cachePathFor(key))) return false;
+	if (file.size() < sizeof(Header)) return false;
+
+	const Header& header = *reinterpret_cast<const Header*>(file.data());
+	if (header.magic != Magic || header.version != Version) return false;
+	if (header.key != key.hash || header.sourceSize != key.sourceSize) return false;
+	if (header.dimensions != static_cast<uint32_t>(key.dimensions) || header.processing != key.processing) return false;
+
+	// Make sure a truncated or corrupted cache cannot make us read out of bounds
+	if (header.vertexOffset % BlobAlignment != 0 || header.indexOffset % BlobAlignment != 0) return false;
+	if (header.vertexLayout.stride == 0) return false;
+	// (a shared cache directory can hold entries written by anyone)
+	if (!fitsArray(header.vertexOffset, header.vertexCount, header.vertexLayout.stride, file.size())) return false;
+	WGPUIndexFormat indexFormat = static_cast<WGPUIndexFormat>(header.indexFormat);
+	if (indexFormat != WGPUIndexFormat_Uint16 && indexFormat != WGPUIndexFormat_Uint32) return false;
+	// Bounding the count first keeps indexDataSize() from overflowing
+	if (!fitsArray(header.indexOffset, header.indexCount, Geometry::indexSize(indexFormat), file.size())) return false;
+	if (header.indexDataSize != Geometry::indexDataSize(indexFormat, header.indexCount)) return false;
+	if (!fits(header.indexOffset, header.indexDataSize, file.size())) return false;
+	if (header.meshletOffset % BlobAlignment != 0) return false;
+	if (!fitsArray(header.meshletOffset, header.meshletCount, sizeof(Meshlet), file.size())) return false;
+	if (header.lodOffset % BlobAlignment != 0) return false;
+	if (!fitsArray(header.lodOffset, header.lodCount, sizeof(MeshLod), file.size())) return false;
+
+	// Nor can a stale or corrupted one draw or cull past the index buffer
+	const Meshlet* meshletData = reinterpret_cast<const Meshlet*>(file.data() + header.meshletOffset);
+	for (uint64_t i = 0; i < header.meshletCount; ++i) {
+		if (!fits(meshletData[i].indexOffset, meshletData[i].indexCount, header.indexCount)) return false;
+	}
+	const MeshLod* lodData = reinterpret_cast<const MeshLod*>(file.data() + header.lodOffset);
+	for (uint64_t i = 0; i < header.lodCount; ++i) {
+		if (!fits(lodData[i].indexOffset, lodData[i].indexCount, header.indexCount)) return false;
+		if (!fits(lodData[i].meshletOffset, lodData[i].meshletCount, header.meshletCount)) return false;
+	}
+
+	const VertexLayout vertexLayout = header.vertexLayout;
+	const MeshBounds bounds = header.bounds;
+	const void* vertexData = file.data() + header.vertexOffset;
+	const void* indexData = file.data() + header.indexOffset;
+	geometry.assign(
+		std::move(file),
+		vertexData, static_cast<size_t>(header.vertexCount), vertexLayout,
+		indexData, static_cast<size_t>(header.indexCount), indexFormat,
+		meshletData, static_cast<size_t>(header.meshletCount),
+		lodData, static_cast<size_t>(header.lodCount)
+	);
+	geometry.setBounds(bounds);
+	return true;
+}
+
+bool MeshCache::write(const Key& key, const Geometry& geometry)
+{
+	Writer writer;
+	if (!writer.open(
+		key,
+		geometry.vertexCount(), geometry.vertexLayout(),
+		geometry.indexCount(), geometry.indexFormat(),
+		geometry.meshletCount(), geometry.lodCount()
+	)) return false;
+	writer.writeVertices(0, geometry.vertexData(), geometry.vertexDataSize());
+	writer.writeIndices(0, geometry.indexData(), geometry.indexCount() * Geometry::indexSize(geometry.indexFormat()));
+	writer.writeMeshlets(0, geometry.meshletData(), geometry.meshletCount());
+	writer.writeLods(0, geometry.lodData(), geometry.lodCount());
+	writer.setBounds(geometry.bounds());
+	return writer.close();
+}
+
+MeshCache::Writer::~Writer()
+{
+	if (!m_file.is_open()) return;
+	m_file.close();
+	std::error_code ec;
+	std::filesystem::remove(m_tmpPath, ec);
+}
+
+bool MeshCache::Writer::open(
+	const Key& key,
+	size_t vertexCount, const VertexLayout& vertexLayout,
+	size_t indexCount, WGPUIndexFormat indexFormat,
+	size_t meshletCount,
+	size_t lodCount
+)
+{
+	m_header = {};
+	m_header.magic = Magic;
+	m_header.version = Version;
+	m_header.key = key.hash;
+	m_header.sourceSize = key.sourceSize;
+	m_header.dimensions = static_cast<uint32_t>(key.dimensions);
+	m_header.indexFormat = static_cast<uint32_t>(indexFormat);
+	m_header.processing = key.processing;
+	m_header.vertexLayout = vertexLayout;
+	m_header.vertexOffset = alignUp(sizeof(Header), BlobAlignment);
+	m_header.vertexCount = vertexCount;
+	m_header.indexOffset = alignUp(m_header.vertexOffset + vertexCount * vertexLayout.stride, BlobAlignment);
+	m_header.indexCount = indexCount;
+	m_header.indexDataSize = Geometry::indexDataSize(indexFormat, indexCount);
+	m_header.meshletOffset = alignUp(m_header.indexOffset + m_header.indexDataSize, BlobAlignment);
+	m_header.meshletCount = meshletCount;
+	m_header.lodOffset = alignUp(m_header.meshletOffset + meshletCount * sizeof(Meshlet), BlobAlignment);
+	m_header.lodCount = lodCount;
+
+	// Write to a temporary file first so that a concurrent reader or a crash
+	// never leaves a half-written cache behind. Each writer gets its own, as
+	// the same file may be loaded twice at once (see ResourceLoader), or by
+	// another machine sharing the cache directory.
+	m_cachePath = cachePathFor(key);
+	m_tmpPath = AssetCache::temporaryPath(m_cachePath);
+	m_file.open(m_tmpPath, std::ios::binary | std::ios::trunc);
+	if (!m_file.is_open()) return false;
+
+	m_file.write(reinterpret_cast<const char*>(&m_header), sizeof(m_header));
+	// Extend the file to its final size, so that alignment and index padding
+	// bytes are zero whatever order the blobs are written in.
+	uint64_t fileSize = m_header.lodOffset + lodCount * sizeof(MeshLod);
+	if (fileSize > sizeof(m_header)) {
+		m_file.seekp(static_cast<std::streamoff>(fileSize - 1));
+		m_file.put('\0');
+	}
+	return m_file.good();
+}
+
+void MeshCache::Writer::writeVertices(size_t offset, const void* data, size_t size)
+{
+	if (size == 0) return;
+	m_file.seekp(static_cast<std::streamoff>(m_header.vertexOffset + offset));
+	m_file.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+}
+
+void MeshCache::Writer::writeIndices(size_t offset, const void* data, size_t size)
+{
+	if (size == 0) return;
+	m_file.seekp(static_cast<std::streamoff>(m_header.indexOffset + offset));
+	m_file.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+}
+
+void MeshCache::Writer::writeMeshlets(size_t offset, const Meshlet* data, size_t count)
+{
+	if (count == 0) return;
+	m_file.seekp(static_cast<std::streamoff>(m_header.meshletOffset + offset * sizeof(Meshlet)));
+	m_file.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(count * sizeof(Meshlet)));
+}
+
+void MeshCache::Writer::writeLods(size_t offset, const MeshLod* data, size_t count)
+{
+	if (count == 0) return;
+	m_file.seekp(static_cast<std::streamoff>(m_header.lodOffset + offset * sizeof(MeshLod)));
+	m_file.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(count * sizeof(MeshLod)));
+}
+
+bool MeshCache::Writer::close()
+{
+	if (!m_file.is_open()) return false;
+	// The header may have changed since open() (see setBounds())
+	m_file.seekp(0);
+	m_file.write(reinterpret_cast<const char*>(&m_header), sizeof(m_header));
+	bool success = m_file.good();
+	m_file.close();
+
+	if (success) {
+		return AssetCache::publish(m_tmpPath, m_cachePath);
+	}
+	std::error_code ec;
+	std::filesystem::remove(m_tmpPath, ec);
+	return false;
+}
@@ -0,0 +1,148 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <type_traits>
+#include <webgpu/webgpu.h>
+#include "Geometry.h"
+
+/**
+ * Binary mesh cache, stored as content-addressed entries of the AssetCache.
+ *
+ * Layout (native endianness, the cache is a local artifact):
+ *   MeshCacheHeader
+ *   vertex blob (vertexCount vertices laid out as vertexLayout describes,
+ *                starts on a 16-byte boundary)
+ *   index blob  (uint16_t or uint32_t[indexCount], see indexFormat,
+ *                starts on a 16-byte boundary, zero-padded to a multiple
+ *                of 4 bytes)
+ *   meshlet blob (Meshlet[meshletCount], starts on a 16-byte boundary)
+ *   LOD blob     (MeshLod[lodCount],     starts on a 16-byte boundary)
+ *
+ * Entries are keyed by a hash of the bytes of the text geometry file, the
+ * dimensions, the GeometryProcessing flags and the cache version, so they are
+ * valid on any machine that has the same source file. The header repeats the
+ * key, which guards against a file ending up under the wrong name.
+ */
+class MeshCache
+{
+public:
+	static constexpr uint32_t Magic = 0x4D534757; // "WGSM" in little endian
+	static constexpr uint32_t Version = 9;
+	static constexpr uint64_t BlobAlignment = 16;
+
+	struct Header
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint64_t key;
+		uint64_t sourceSize;
+		uint32_t dimensions;
+		uint32_t indexFormat; // WGPUIndexFormat
+		uint32_t processing; // GeometryProcessing
+		uint32_t _pad;
+		VertexLayout vertexLayout;
+		MeshBounds bounds;
+		uint64_t vertexOffset;
+		uint64_t vertexCount;
+		uint64_t indexOffset;
+		uint64_t indexCount;
+		uint64_t indexDataSize;
+		uint64_t meshletOffset;
+		uint64_t meshletCount;
+		uint64_t lodOffset;
+		uint64_t lodCount;
+	};
+	static_assert(std::is_trivially_copyable<Header>::value, "the header is read straight from the mapped file");
+
+	/**
+	 * Everything a cache entry derives from.
+	 */
+	struct Key
+	{
+		uint64_t hash = 0;
+		uint64_t sourceSize = 0;
+		int dimensions = 0;
+		GeometryProcessing processing = GeometryProcessing_None;
+	};
+
+	/**
+	 * Key of the geometry parsed from `sourceData` with the given options.
+	 */
+	static Key makeKey(const void* sourceData, size_t sourceSize, int dimensions, GeometryProcessing processing);
+
+	/**
+	 * Same as above, reading the text geometry file at `sourcePath`.
+	 */
+	static bool makeKey(const std::filesystem::path& sourcePath, int dimensions, GeometryProcessing processing, Key& key);
+
+	/**
+	 * Path of the cache entry of `key` (see AssetCache).
+	 */
+	static std::filesystem::path cachePathFor(const Key& key);
+
+	/**
+	 * Map the cache entry of `key` into `geometry`. Return false if there is
+	 * no such entry, in which case `geometry` is left untouched.
+	 */
+	static bool read(const Key& key, Geometry& geometry);
+
+	/**
+	 * Write the cache entry of `key` from already loaded geometry.
+	 */
+	static bool write(const Key& key, const Geometry& geometry);
+
+	/**
+	 * Incremental cache writer, for when the geometry is never held in memory
+	 * as a whole (see GeometryStreamer). The file is laid out on open() from
+	 * the final counts, then filled in any order.
+	 */
+	class Writer
+	{
+	public:
+		Writer() = default;
+		// Remove the temporary file of an entry that was never closed, e.g.
+		// when the application quits while streaming
+		~Writer();
+
+		Writer(const Writer&) = delete;
+		Writer& operator=(const Writer&) = delete;
+
+		bool open(
+			const Key& key,
+			size_t vertexCount, const VertexLayout& vertexLayout,
+			size_t indexCount, WGPUIndexFormat indexFormat,
+			size_t meshletCount = 0,
+			size_t lodCount = 0
+		);
+
+		// `offset` and `size` are in bytes from the start of the vertex blob
+		void writeVertices(size_t offset, const void* data, size_t size);
+		// `offset` and `size` are in bytes from the start of the index blob.
+		// Indices are in the format given to open(). Indices written past
+		// `indexCount` must be 0 and land in the blob padding.
+		void writeIndices(size_t offset, const void* data, size_t size);
+		// `count` meshlets, starting at meshlet number `offset`
+		void writeMeshlets(size_t offset, const Meshlet* data, size_t count);
+		// `count` levels of detail, starting at level number `offset`
+		void writeLods(size_t offset, const MeshLod* data, size_t count);
+
+		/**
+		 * Bounds of the whole mesh, which may only be known once every batch
+		 * went through (see GeometryStreamer::Batch::bounds).
+		 */
+		void setBounds(const MeshBounds& bounds) { m_header.bounds = bounds; }
+
+		/**
+		 * Finish writing and atomically publish the cache entry.
+		 */
+		bool close();
+
+	private:
+		Header m_header = {};
+		std::ofstream m_file;
+		std::filesystem::path m_cachePath;
+		std::filesystem::path m_tmpPath;
+	};
+};
@@ -0,0 +1,264 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <numeric>
+
+namespace
+{
+	using Vec3 = std::array<double, 3>;
+
+	Vec3 sub(const Vec3& a, const Vec3& b) { return { a[0] - b[0], a[1] - b[1], a[2] - b[2] }; }
+	double dot(const Vec3& a, const Vec3& b) { return a[0] * b[0] + a[1] * b[1] + a[2] * b[2]; }
+	Vec3 cross(const Vec3& a, const Vec3& b)
+	{
+		return { a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2], a[0] * b[1] - a[1] * b[0] };
+	}
+
+	Vec3 position(const std::vector<float>& pointData, uint32_t vertex, int dimensions, int stride)
+	{
+		const float* p = pointData.data() + static_cast<size_t>(vertex) * stride;
+		return { p[0], dimensions > 1 ? p[1] : 0.0, dimensions > 2 ? p[2] : 0.0 };
+	}
+
+	/**
+	 * Triangles adjacent to each vertex, in compressed row storage.
+	 */
+	struct Adjacency {
+		std::vector<uint32_t> offsets;
+		std::vector<uint32_t> triangles;
+
+		Adjacency(const std::vector<uint32_t>& indexData, size_t vertexCount)
+			: offsets(vertexCount + 1, 0)
+			, triangles(indexData.size())
+		{
+			for (uint32_t index : indexData) ++offsets[index + 1];
+			std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+			std::vector<uint32_t> cursor(offsets.begin(), offsets.end() - 1);
+			for (size_t i = 0; i < indexData.size(); ++i) {
+				triangles[cursor[indexData[i]]++] = static_cast<uint32_t>(i / 3);
+			}
+		}
+	};
+}
+
+MeshOptimizer::CacheStats MeshOptimizer::analyzeVertexCache(const std::vector<uint32_t>& indexData, size_t vertexCount)
+{
+	CacheStats stats;
+	size_t triangleCount = indexData.size() / 3;
+	if (triangleCount == 0) return stats;
+
+	// FIFO cache: a vertex is a hit if it entered the cache less than
+	// CacheSize misses ago
+	std::vector<size_t> timestamps(vertexCount, 0);
+	std::vector<bool> referenced(vertexCount, false);
+	size_t misses = 0;
+	size_t referencedCount = 0;
+	for (size_t i = 0; i < triangleCount * 3; ++i) {
+		uint32_t vertex = indexData[i];
+		if (vertex >= vertexCount) continue;
+		if (!referenced[vertex]) {
+			referenced[vertex] = true;
+			++referencedCount;
+		}
+		if (timestamps[vertex] == 0 || misses + 1 - timestamps[vertex] > CacheSize) {
+			++misses;
+			timestamps[vertex] = misses;
+		}
+	}
+
+	stats.acmr = static_cast<float>(misses) / static_cast<float>(triangleCount);
+	stats.atvr = referencedCount > 0 ? static_cast<float>(misses) / static_cast<float>(referencedCount) : 0.0f;
+	return stats;
+}
+
+bool MeshOptimizer::optimize(std::vector<float>& pointData, std::vector<uint32_t>& indexData, int dimensions, int stride)
+{
+	size_t vertexCount = pointData.size() / static_cast<size_t>(stride);
+	for (uint32_t index : indexData) {
+		if (index >= vertexCount) return false;
+	}
+
+	std::vector<uint32_t> clusters;
+	indexData = reorderForVertexCache(indexData, vertexCount, clusters);
+	indexData = reorderForOverdraw(pointData, indexData, clusters, dimensions, stride);
+	reorderForVertexFetch(pointData, indexData, stride);
+	return true;
+}
+
+std::vector<uint32_t> MeshOptimizer::reorderForVertexCache(
+	const std::vector<uint32_t>& indexData,
+	size_t vertexCount,
+	std::vector<uint32_t>& clusters
+)
+{
+	const size_t triangleCount = indexData.size() / 3;
+	std::vector<uint32_t> output;
+	output.reserve(triangleCount * 3);
+	clusters.clear();
+	if (triangleCount == 0 || vertexCount == 0) return output;
+
+	Adjacency adjacency(indexData, vertexCount);
+	std::vector<uint32_t> liveTriangles(vertexCount);
+	for (size_t v = 0; v < vertexCount; ++v) {
+		liveTriangles[v] = adjacency.offsets[v + 1] - adjacency.offsets[v];
+	}
+
+	std::vector<size_t> cacheTime(vertexCount, 0);
+	std::vector<bool> emitted(triangleCount, false);
+	std::vector<uint32_t> deadEnds;
+	std::vector<uint32_t> candidates;
+	size_t time = CacheSize + 1;
+	size_t cursor = 0;
+
+	// Fall back on the most recently referenced vertex that still has live
+	// triangles, or else on the next one in input order.
+	auto skipDeadEnd = [&]() -> int64_t {
+		while (!deadEnds.empty()) {
+			uint32_t vertex = deadEnds.back();
+			deadEnds.pop_back();
+			if (liveTriangles[vertex] > 0) return vertex;
+		}
+		for (; cursor < vertexCount; ++cursor) {
+			if (liveTriangles[cursor] > 0) return static_cast<int64_t>(cursor);
+		}
+		return -1;
+	};
+
+	int64_t fanning = skipDeadEnd();
+	while (fanning >= 0) {
+		// Emit all live triangles around the fanning vertex
+		candidates.clear();
+		uint32_t f = static_cast<uint32_t>(fanning);
+		for (uint32_t k = adjacency.offsets[f]; k < adjacency.offsets[f + 1]; ++k) {
+			uint32_t triangle = adjacency.triangles[k];
+			if (emitted[triangle]) continue;
+			emitted[triangle] = true;
+			for (int corner = 0; corner < 3; ++corner) {
+				uint32_t vertex = indexData[3 * triangle + corner];
+				output.push_back(vertex);
+				deadEnds.push_back(vertex);
+				candidates.push_back(vertex);
+				--liveTriangles[vertex];
+				if (time - cacheTime[vertex] > CacheSize) {
+					cacheTime[vertex] = time++;
+				}
+			}
+		}
+
+		// Pick the next fanning vertex among the ones just referenced: the
+		// oldest one in cache that will still be in cache after its fan.
+		int64_t next = -1;
+		int64_t bestPriority = -1;
+		for (uint32_t vertex : candidates) {
+			if (liveTriangles[vertex] == 0) continue;
+			int64_t priority = 0;
+			if (time - cacheTime[vertex] + 2 * liveTriangles[vertex] <= CacheSize) {
+				priority = static_cast<int64_t>(time - cacheTime[vertex]);
+			}
+			if (priority > bestPriority) {
+				bestPriority = priority;
+				next = vertex;
+			}
+		}
+		if (next < 0) {
+			// Dead end: the cache content is of no use for what follows, so
+			// this is a natural cluster boundary for the overdraw pass.
+			next = skipDeadEnd();
+			if (next >= 0) clusters.push_back(static_cast<uint32_t>(output.size() / 3));
+		}
+		fanning = next;
+	}
+	clusters.insert(clusters.begin(), 0);
+	return output;
+}
+
+std::vector<uint32_t> MeshOptimizer::reorderForOverdraw(
+	const std::vector<float>& pointData,
+	const std::vector<uint32_t>& indexData,
+	const std::vector<uint32_t>& clusters,
+	int dimensions,
+	int stride
+)
+{
+	const size_t triangleCount = indexData.size() / 3;
+	const size_t clusterCount = clusters.size();
+	if (clusterCount <= 1) return indexData;
+
+	// Area weighted centroid and normal of each cluster and of the mesh
+	std::vector<Vec3> clusterCentroids(clusterCount, Vec3{ 0, 0, 0 });
+	std::vector<Vec3> clusterNormals(clusterCount, Vec3{ 0, 0, 0 });
+	std::vector<double> clusterAreas(clusterCount, 0.0);
+	Vec3 meshCentroid = { 0, 0, 0 };
+	double meshArea = 0.0;
+	for (size_t c = 0; c < clusterCount; ++c) {
+		size_t end = c + 1 < clusterCount ? clusters[c + 1] : triangleCount;
+		for (size_t t = clusters[c]; t < end; ++t) {
+			Vec3 a = position(pointData, indexData[3 * t + 0], dimensions, stride);
+			Vec3 b = position(pointData, indexData[3 * t + 1], dimensions, stride);
+			Vec3 d = position(pointData, indexData[3 * t + 2], dimensions, stride);
+			Vec3 normal = cross(sub(b, a), sub(d, a));
+			double area = 0.5 * std::sqrt(dot(normal, normal));
+			for (int i = 0; i < 3; ++i) {
+				double center = (a[i] + b[i] + d[i]) / 3.0;
+				clusterCentroids[c][i] += center * area;
+				clusterNormals[c][i] += normal[i];
+				meshCentroid[i] += center * area;
+			}
+			clusterAreas[c] += area;
+			meshArea += area;
+		}
+	}
+	if (meshArea > 0.0) {
+		for (double& x : meshCentroid) x /= meshArea;
+	}
+
+	std::vector<double> sortKey(clusterCount, 0.0);
+	for (size_t c = 0; c < clusterCount; ++c) {
+		if (clusterAreas[c] <= 0.0) continue;
+		Vec3 centroid = clusterCentroids[c];
+		for (double& x : centroid) x /= clusterAreas[c];
+		sortKey[c] = dot(sub(centroid, meshCentroid), clusterNormals[c]);
+	}
+
+	std::vector<uint32_t> order(clusterCount);
+	std::iota(order.begin(), order.end(), 0);
+	std::stable_sort(order.begin(), order.end(), [&sortKey](uint32_t a, uint32_t b) {
+		return sortKey[a] > sortKey[b];
+	});
+
+	std::vector<uint32_t> output;
+	output.reserve(indexData.size());
+	for (uint32_t c : order) {
+		size_t end = c + 1 < clusterCount ? clusters[c + 1] : triangleCount;
+		output.insert(output.end(), indexData.begin() + 3 * clusters[c], indexData.begin() + 3 * end);
+	}
+	return output;
+}
+
+void MeshOptimizer::reorderForVertexFetch(std::vector<float>& pointData, std::vector<uint32_t>& indexData, int stride)
+{
+	const size_t vertexCount = pointData.size() / static_cast<size_t>(stride);
+	constexpr uint32_t Unassigned = UINT32_MAX;
+
+	std::vector<uint32_t> remap(vertexCount, Unassigned);
+	uint32_t nextVertex = 0;
+	for (uint32_t& index : indexData) {
+		if (index >= vertexCount) continue;
+		if (remap[index] == Unassigned) remap[index] = nextVertex++;
+		index = remap[index];
+	}
+	for (uint32_t& newIndex : remap) {
+		if (newIndex == Unassigned) newIndex = nextVertex++;
+	}
+
+	std::vector<float> reordered(pointData.size());
+	for (size_t v = 0; v < vertexCount; ++v) {
+		std::copy_n(
+			pointData.begin() + v * stride, stride,
+			reordered.begin() + static_cast<size_t>(remap[v]) * stride
+		);
+	}
+	pointData.swap(reordered);
+}
@@ -0,0 +1,74 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Post-load mesh optimisation, reordering triangles and vertices without
+ * changing the rendered result:
+ *  1. Tipsify triangle reordering for post-transform vertex cache reuse
+ *     (Sander, Nehab & Barczak, "Fast Triangle Reordering for Vertex
+ *     Locality and Reduced Overdraw", 2007),
+ *  2. overdraw-aware reordering of the clusters Tipsify produces, drawing
+ *     outward facing clusters first so that they occlude the others,
+ *  3. vertex fetch reordering, which remaps the point buffer so that
+ *     vertices are stored in the order they are first referenced.
+ *
+ * Points are interleaved floats, `stride` floats per vertex, the first
+ * `dimensions` of which are the position.
+ */
+class MeshOptimizer
+{
+public:
+	// Size of the FIFO post-transform cache Tipsify optimises for and that
+	// the statistics are simulated with
+	static constexpr uint32_t CacheSize = 16;
+
+	struct CacheStats {
+		// Average cache miss ratio: transformed vertices per triangle (0.5 at best, 3 at worst)
+		float acmr = 0.0f;
+		// Average transform to vertex ratio: transformed vertices per referenced vertex (1 at best)
+		float atvr = 0.0f;
+	};
+
+	/**
+	 * Simulate a FIFO vertex cache of CacheSize entries on an index buffer.
+	 */
+	static CacheStats analyzeVertexCache(const std::vector<uint32_t>& indexData, size_t vertexCount);
+
+	/**
+	 * Run the three passes above in place. `indexData` keeps the same
+	 * triangles, with their winding, and `pointData` the same vertices.
+	 * Return false and leave the mesh untouched if an index is out of range.
+	 */
+	static bool optimize(std::vector<float>& pointData, std::vector<uint32_t>& indexData, int dimensions, int stride);
+
+	/**
+	 * Tipsify triangle order. Return the reordered index buffer and fill
+	 * `clusters` with the index of the first triangle of each cluster, a
+	 * cluster ending wherever Tipsify has to jump to a new fanning vertex.
+	 */
+	static std::vector<uint32_t> reorderForVertexCache(
+		const std::vector<uint32_t>& indexData,
+		size_t vertexCount,
+		std::vector<uint32_t>& clusters
+	);
+
+	/**
+	 * Reorder whole clusters (as returned by reorderForVertexCache) so that
+	 * the ones facing away from the mesh center come first.
+	 */
+	static std::vector<uint32_t> reorderForOverdraw(
+		const std::vector<float>& pointData,
+		const std::vector<uint32_t>& indexData,
+		const std::vector<uint32_t>& clusters,
+		int dimensions,
+		int stride
+	);
+
+	/**
+	 * Renumber vertices in order of first use and reorder `pointData`
+	 * accordingly. Unreferenced vertices are moved to the end.
+	 */
+	static void reorderForVertexFetch(std::vector<float>& pointData, std::vector<uint32_t>& indexData, int stride);
+};
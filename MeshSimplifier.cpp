@@ -0,0 +1,321 @@
+#include "MeshSimplifier.h"
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <unordered_map>
+
+namespace
+{
+	using Vec3 = std::array<double, 3>;
+
+	Vec3 sub(const Vec3& a, const Vec3& b) { return { a[0] - b[0], a[1] - b[1], a[2] - b[2] }; }
+	double dot(const Vec3& a, const Vec3& b) { return a[0] * b[0] + a[1] * b[1] + a[2] * b[2]; }
+	Vec3 cross(const Vec3& a, const Vec3& b)
+	{
+		return { a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2], a[0] * b[1] - a[1] * b[0] };
+	}
+
+	/**
+	 * Symmetric 4x4 matrix accumulating squared distances to planes,
+	 * weighted by the area of the triangles they come from.
+	 */
+	struct Quadric {
+		// a00 a01 a02 a03 a11 a12 a13 a22 a23 a33
+		std::array<double, 10> m = {};
+		double weight = 0.0;
+
+		void addPlane(const Vec3& n, double d, double w)
+		{
+			m[0] += w * n[0] * n[0]; m[1] += w * n[0] * n[1]; m[2] += w * n[0] * n[2]; m[3] += w * n[0] * d;
+			m[4] += w * n[1] * n[1]; m[5] += w * n[1] * n[2]; m[6] += w * n[1] * d;
+			m[7] += w * n[2] * n[2]; m[8] += w * n[2] * d;
+			m[9] += w * d * d;
+			weight += w;
+		}
+
+		void add(const Quadric& other)
+		{
+			for (size_t i = 0; i < m.size(); ++i) m[i] += other.m[i];
+			weight += other.weight;
+		}
+
+		// Weighted mean squared distance of `p` to the planes
+		double error(const Vec3& p) const
+		{
+			const double x = p[0], y = p[1], z = p[2];
+			double e =
+				m[0] * x * x + 2 * m[1] * x * y + 2 * m[2] * x * z + 2 * m[3] * x
+				+ m[4] * y * y + 2 * m[5] * y * z + 2 * m[6] * y
+				+ m[7] * z * z + 2 * m[8] * z
+				+ m[9];
+			return weight > 0.0 ? std::max(e, 0.0) / weight : 0.0;
+		}
+	};
+
+	struct Collapse {
+		uint32_t from;
+		uint32_t to;
+		double cost;
+	};
+
+	Vec3 position(const std::vector<float>& pointData, uint32_t vertex, int dimensions, int stride)
+	{
+		const float* p = pointData.data() + static_cast<size_t>(vertex) * stride;
+		return { p[0], dimensions > 1 ? p[1] : 0.0, dimensions > 2 ? p[2] : 0.0 };
+	}
+
+	Vec3 triangleNormal(const Vec3& a, const Vec3& b, const Vec3& c)
+	{
+		return cross(sub(b, a), sub(c, a));
+	}
+
+	/**
+	 * Flag border vertices (on an edge used by a single triangle) and
+	 * vertices sharing their position with another one.
+	 */
+	std::vector<bool> lockedVertices(const std::vector<Vec3>& positions, const std::vector<uint32_t>& indexData)
+	{
+		const size_t vertexCount = positions.size();
+		std::vector<bool> locked(vertexCount, false);
+
+		std::unordered_map<uint64_t, int> edgeUses;
+		edgeUses.reserve(indexData.size());
+		for (size_t i = 0; i + 2 < indexData.size(); i += 3) {
+			for (size_t k = 0; k < 3; ++k) {
+				uint64_t a = indexData[i + k], b = indexData[i + (k + 1) % 3];
+				++edgeUses[std::min(a, b) << 32 | std::max(a, b)];
+			}
+		}
+		for (const auto& [edge, uses] : edgeUses) {
+			if (uses == 1) {
+				locked[edge >> 32] = true;
+				locked[edge & 0xFFFFFFFF] = true;
+			}
+		}
+
+		std::vector<uint32_t> order(vertexCount);
+		std::iota(order.begin(), order.end(), 0);
+		std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return positions[a] < positions[b]; });
+		for (size_t i = 1; i < order.size(); ++i) {
+			if (positions[order[i]] == positions[order[i - 1]]) {
+				locked[order[i]] = true;
+				locked[order[i - 1]] = true;
+			}
+		}
+		return locked;
+	}
+}
+
+std::vector<uint32_t> MeshSimplifier::simplify(
+	const std::vector<float>& pointData,
+	const std::vector<uint32_t>& indexData,
+	int dimensions,
+	int stride,
+	size_t targetIndexCount,
+	float& error
+)
+{
+	error = 0.0f;
+	const size_t vertexCount = pointData.size() / static_cast<size_t>(stride);
+	std::vector<uint32_t> indices(indexData.begin(), indexData.begin() + indexData.size() / 3 * 3);
+	for (uint32_t index : indices) {
+		if (index >= vertexCount) return indexData;
+	}
+
+	std::vector<Vec3> positions(vertexCount);
+	for (size_t v = 0; v < vertexCount; ++v) {
+		positions[v] = position(pointData, static_cast<uint32_t>(v), dimensions, stride);
+	}
+	const std::vector<bool> locked = lockedVertices(positions, indices);
+
+	std::vector<Quadric> quadrics(vertexCount);
+	for (size_t i = 0; i < indices.size(); i += 3) {
+		const Vec3& a = positions[indices[i]];
+		Vec3 n = triangleNormal(a, positions[indices[i + 1]], positions[indices[i + 2]]);
+		double length = std::sqrt(dot(n, n));
+		if (length == 0.0) continue;
+		n = { n[0] / length, n[1] / length, n[2] / length };
+		double area = 0.5 * length;
+		for (size_t k = 0; k < 3; ++k) {
+			quadrics[indices[i + k]].addPlane(n, -dot(n, a), area);
+		}
+	}
+
+	double maxCost = 0.0;
+	std::vector<uint32_t> remap(vertexCount);
+	std::vector<bool> touched(vertexCount);
+	std::vector<Collapse> collapses;
+	std::vector<uint32_t> offsets;
+	std::vector<uint32_t> adjacency;
+
+	// Each pass collapses, cheapest first, a set of edges that do not share
+	// any triangle, so that they can be validated independently.
+	while (indices.size() > targetIndexCount) {
+		const size_t triangleCount = indices.size() / 3;
+
+		// Triangles around each vertex
+		offsets.assign(vertexCount + 1, 0);
+		for (uint32_t index : indices) ++offsets[index + 1];
+		std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+		adjacency.resize(indices.size());
+		std::vector<uint32_t> cursor(offsets.begin(), offsets.end() - 1);
+		for (size_t i = 0; i < indices.size(); ++i) {
+			adjacency[cursor[indices[i]]++] = static_cast<uint32_t>(i / 3);
+		}
+
+		// Cheapest direction of each edge (edges are listed once per triangle,
+		// which the touched flags below make harmless)
+		collapses.clear();
+		for (size_t t = 0; t < triangleCount; ++t) {
+			for (size_t k = 0; k < 3; ++k) {
+				uint32_t a = indices[3 * t + k], b = indices[3 * t + (k + 1) % 3];
+				if (a > b) continue;
+				Quadric q = quadrics[a];
+				q.add(quadrics[b]);
+				double costAB = locked[a] ? std::numeric_limits<double>::infinity() : q.error(positions[b]);
+				double costBA = locked[b] ? std::numeric_limits<double>::infinity() : q.error(positions[a]);
+				if (locked[a] && locked[b]) continue;
+				collapses.push_back(costAB <= costBA ? Collapse{ a, b, costAB } : Collapse{ b, a, costBA });
+			}
+		}
+		std::sort(collapses.begin(), collapses.end(), [](const Collapse& x, const Collapse& y) { return x.cost < y.cost; });
+
+		std::iota(remap.begin(), remap.end(), 0);
+		std::fill(touched.begin(), touched.end(), false);
+		size_t removedTriangles = 0;
+		const size_t triangleBudget = (indices.size() - targetIndexCount + 2) / 3;
+		size_t collapseCount = 0;
+		for (const Collapse& collapse : collapses) {
+			if (removedTriangles >= triangleBudget) break;
+			if (touched[collapse.from] || touched[collapse.to]) continue;
+
+			// Reject collapses that would flip a triangle around `from`
+			bool valid = true;
+			size_t removed = 0;
+			for (uint32_t j = offsets[collapse.from]; j < offsets[collapse.from + 1] && valid; ++j) {
+				const uint32_t* triangle = &indices[3 * adjacency[j]];
+				if (triangle[0] == collapse.to || triangle[1] == collapse.to || triangle[2] == collapse.to) {
+					++removed;
+					continue;
+				}
+				Vec3 corners[3];
+				Vec3 moved[3];
+				for (size_t k = 0; k < 3; ++k) {
+					corners[k] = positions[triangle[k]];
+					moved[k] = triangle[k] == collapse.from ? positions[collapse.to] : corners[k];
+				}
+				Vec3 before = triangleNormal(corners[0], corners[1], corners[2]);
+				Vec3 after = triangleNormal(moved[0], moved[1], moved[2]);
+				valid = dot(before, after) > 0.0;
+			}
+			if (!valid) continue;
+
+			remap[collapse.from] = collapse.to;
+			quadrics[collapse.to].add(quadrics[collapse.from]);
+			maxCost = std::max(maxCost, collapse.cost);
+			removedTriangles += removed;
+			++collapseCount;
+			// Lock the neighborhood for the rest of this pass
+			for (uint32_t j = offsets[collapse.from]; j < offsets[collapse.from + 1]; ++j) {
+				const uint32_t* triangle = &indices[3 * adjacency[j]];
+				touched[triangle[0]] = touched[triangle[1]] = touched[triangle[2]] = true;
+			}
+		}
+		if (collapseCount == 0) break;
+
+		// Apply the collapses and drop the triangles that became degenerate
+		size_t write = 0;
+		for (size_t i = 0; i < indices.size(); i += 3) {
+			uint32_t a = remap[indices[i]], b = remap[indices[i + 1]], c = remap[indices[i + 2]];
+			if (a == b || b == c || c == a) continue;
+			indices[write++] = a;
+			indices[write++] = b;
+			indices[write++] = c;
+		}
+		indices.resize(write);
+	}
+
+	error = static_cast<float>(std::sqrt(maxCost));
+	return indices;
+}
+
+std::vector<MeshLod> MeshSimplifier::buildLods(
+	const std::vector<float>& pointData,
+	std::vector<uint32_t>& indexData,
+	int dimensions,
+	int stride
+)
+{
+	std::vector<MeshLod> lods;
+	const size_t vertexCount = pointData.size() / static_cast<size_t>(stride);
+	for (uint32_t index : indexData) {
+		if (index >= vertexCount) return lods;
+	}
+
+	// All levels use a subset of the base vertices, so they share its bounds
+	MeshLod base = {};
+	Vec3 boxMin = { std::numeric_limits<double>::max(), std::numeric_limits<double>::max(), std::numeric_limits<double>::max() };
+	Vec3 boxMax = { std::numeric_limits<double>::lowest(), std::numeric_limits<double>::lowest(), std::numeric_limits<double>::lowest() };
+	for (uint32_t index : indexData) {
+		Vec3 p = position(pointData, index, dimensions, stride);
+		for (int c = 0; c < 3; ++c) {
+			boxMin[c] = std::min(boxMin[c], p[c]);
+			boxMax[c] = std::max(boxMax[c], p[c]);
+		}
+	}
+	if (!indexData.empty()) {
+		Vec3 center = { 0.5 * (boxMin[0] + boxMax[0]), 0.5 * (boxMin[1] + boxMax[1]), 0.5 * (boxMin[2] + boxMax[2]) };
+		double radius2 = 0.0;
+		for (uint32_t index : indexData) {
+			Vec3 d = sub(position(pointData, index, dimensions, stride), center);
+			radius2 = std::max(radius2, dot(d, d));
+		}
+		for (int c = 0; c < 3; ++c) base.center[c] = static_cast<float>(center[c]);
+		base.radius = static_cast<float>(std::sqrt(radius2));
+	}
+	base.indexCount = static_cast<uint32_t>(indexData.size());
+	lods.push_back(base);
+
+	std::vector<uint32_t> previous = indexData;
+	std::vector<uint32_t> clusters;
+	while (lods.size() < MaxLodCount) {
+		size_t targetIndexCount = previous.size() / 6 * 3;
+		float error;
+		std::vector<uint32_t> simplified = simplify(pointData, previous, dimensions, stride, targetIndexCount, error);
+		// Not worth a level of its own
+		if (simplified.empty() || simplified.size() * 10 > previous.size() * 9) break;
+
+		MeshLod lod = base;
+		// Each level is simplified from the previous one, so errors add up
+		lod.error = lods.back().error + error;
+		lod.indexOffset = static_cast<uint32_t>(indexData.size());
+		lod.indexCount = static_cast<uint32_t>(simplified.size());
+		lods.push_back(lod);
+
+		std::vector<uint32_t> reordered = MeshOptimizer::reorderForVertexCache(simplified, vertexCount, clusters);
+		indexData.insert(indexData.end(), reordered.begin(), reordered.end());
+		previous = std::move(simplified);
+	}
+	return lods;
+}
+
+size_t MeshSimplifier::selectLod(
+	const MeshLod* lods,
+	size_t lodCount,
+	float distance,
+	float pixelsPerUnit,
+	float maxErrorPixels
+)
+{
+	if (lodCount == 0) return 0;
+	if (distance <= 0.0f) return 0;
+	size_t selected = 0;
+	for (size_t i = 1; i < lodCount; ++i) {
+		if (lods[i].error * pixelsPerUnit / distance > maxErrorPixels) break;
+		selected = i;
+	}
+	return selected;
+}
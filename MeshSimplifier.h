@@ -0,0 +1,86 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * One level of detail of a mesh. All levels share the vertex buffer of the
+ * base mesh and use the range [indexOffset, indexOffset + indexCount) of its
+ * index buffer, and the meshlets [meshletOffset, meshletOffset + meshletCount)
+ * when it was built with GeometryProcessing_Meshlets.
+ */
+struct MeshLod
+{
+	// Bounding sphere, in model space
+	std::array<float, 3> center;
+	float radius;
+	// Estimated distance, in model units, between this level and the base mesh
+	float error;
+	uint32_t indexOffset;
+	uint32_t indexCount;
+	uint32_t meshletOffset;
+	uint32_t meshletCount;
+	uint32_t _pad[3];
+};
+
+/**
+ * Mesh simplification by edge collapse, using quadric error metrics
+ * (Garland & Heckbert, "Surface Simplification Using Quadric Error
+ * Metrics", 1997). Vertices are only ever collapsed onto other existing
+ * vertices, so that simplified meshes are new index buffers over the
+ * same vertex buffer.
+ *
+ * Vertices on a mesh border, or sharing their position with another vertex
+ * (attribute seams), never move, which keeps simplified meshes watertight
+ * where the base mesh is.
+ *
+ * Points are interleaved floats, `stride` floats per vertex, the first
+ * `dimensions` of which are the position.
+ */
+class MeshSimplifier
+{
+public:
+	// Number of levels of detail, including the base mesh
+	static constexpr size_t MaxLodCount = 5;
+
+	/**
+	 * Collapse edges of `indexData` until it has at most `targetIndexCount`
+	 * indices, or no edge can be collapsed anymore. `error` is set to the
+	 * largest error of the collapses that were made.
+	 */
+	static std::vector<uint32_t> simplify(
+		const std::vector<float>& pointData,
+		const std::vector<uint32_t>& indexData,
+		int dimensions,
+		int stride,
+		size_t targetIndexCount,
+		float& error
+	);
+
+	/**
+	 * Replace `indexData` by the concatenation of up to MaxLodCount levels of
+	 * detail, each about half the triangles of the previous one, starting
+	 * with the base mesh. Coarser levels are reordered for the vertex cache.
+	 * Stop early when simplification stalls.
+	 */
+	static std::vector<MeshLod> buildLods(
+		const std::vector<float>& pointData,
+		std::vector<uint32_t>& indexData,
+		int dimensions,
+		int stride
+	);
+
+	/**
+	 * Coarsest level whose error, projected at `distance` from the camera,
+	 * is at most `maxErrorPixels`. `pixelsPerUnit` is the size in pixels of
+	 * one model unit at distance 1.
+	 */
+	static size_t selectLod(
+		const MeshLod* lods,
+		size_t lodCount,
+		float distance,
+		float pixelsPerUnit,
+		float maxErrorPixels
+	);
+};
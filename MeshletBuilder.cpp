@@ -0,0 +1,147 @@
+#include "MeshletBuilder.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+	using Vec3 = std::array<double, 3>;
+
+	Vec3 sub(const Vec3& a, const Vec3& b) { return { a[0] - b[0], a[1] - b[1], a[2] - b[2] }; }
+	double dot(const Vec3& a, const Vec3& b) { return a[0] * b[0] + a[1] * b[1] + a[2] * b[2]; }
+	Vec3 cross(const Vec3& a, const Vec3& b)
+	{
+		return { a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2], a[0] * b[1] - a[1] * b[0] };
+	}
+
+	Vec3 position(const std::vector<float>& pointData, uint32_t vertex, int dimensions, int stride)
+	{
+		const float* p = pointData.data() + static_cast<size_t>(vertex) * stride;
+		return { p[0], dimensions > 1 ? p[1] : 0.0, dimensions > 2 ? p[2] : 0.0 };
+	}
+}
+
+std::vector<Meshlet> MeshletBuilder::build(
+	const std::vector<float>& pointData,
+	const std::vector<uint32_t>& indexData,
+	int dimensions,
+	int stride
+)
+{
+	std::vector<Meshlet> meshlets;
+	const size_t triangleCount = indexData.size() / 3;
+	if (triangleCount == 0) return meshlets;
+
+	// Vertices already used by the current meshlet, tagged with its number so
+	// that nothing needs to be reset between meshlets
+	const size_t vertexCount = pointData.size() / static_cast<size_t>(stride);
+	for (uint32_t index : indexData) {
+		if (index >= vertexCount) return meshlets;
+	}
+	std::vector<uint32_t> usedBy(vertexCount, std::numeric_limits<uint32_t>::max());
+
+	Meshlet current = {};
+	size_t currentVertexCount = 0;
+	for (size_t t = 0; t < triangleCount; ++t) {
+		const uint32_t* triangle = &indexData[3 * t];
+		size_t newVertices = 0;
+		for (size_t k = 0; k < 3; ++k) {
+			bool repeated = std::find(triangle, triangle + k, triangle[k]) != triangle + k;
+			if (usedBy[triangle[k]] != meshlets.size() && !repeated) ++newVertices;
+		}
+
+		// Close the current meshlet when this triangle does not fit in
+		if (current.indexCount / 3 == MaxTriangles || currentVertexCount + newVertices > MaxVertices) {
+			computeBounds(current, pointData, indexData, dimensions, stride);
+			meshlets.push_back(current);
+			current = {};
+			current.indexOffset = static_cast<uint32_t>(3 * t);
+			currentVertexCount = 0;
+		}
+
+		const uint32_t tag = static_cast<uint32_t>(meshlets.size());
+		for (size_t k = 0; k < 3; ++k) {
+			if (usedBy[triangle[k]] != tag) {
+				usedBy[triangle[k]] = tag;
+				++currentVertexCount;
+			}
+		}
+		current.indexCount += 3;
+	}
+	computeBounds(current, pointData, indexData, dimensions, stride);
+	meshlets.push_back(current);
+	return meshlets;
+}
+
+void MeshletBuilder::computeBounds(
+	Meshlet& meshlet,
+	const std::vector<float>& pointData,
+	const std::vector<uint32_t>& indexData,
+	int dimensions,
+	int stride
+)
+{
+	const size_t begin = meshlet.indexOffset;
+	const size_t end = begin + meshlet.indexCount;
+
+	// Bounding sphere centered on the bounding box, which is good enough for
+	// clusters this small
+	Vec3 boxMin = { std::numeric_limits<double>::max(), std::numeric_limits<double>::max(), std::numeric_limits<double>::max() };
+	Vec3 boxMax = { std::numeric_limits<double>::lowest(), std::numeric_limits<double>::lowest(), std::numeric_limits<double>::lowest() };
+	for (size_t i = begin; i < end; ++i) {
+		Vec3 p = position(pointData, indexData[i], dimensions, stride);
+		for (int c = 0; c < 3; ++c) {
+			boxMin[c] = std::min(boxMin[c], p[c]);
+			boxMax[c] = std::max(boxMax[c], p[c]);
+		}
+	}
+	Vec3 center = { 0.5 * (boxMin[0] + boxMax[0]), 0.5 * (boxMin[1] + boxMax[1]), 0.5 * (boxMin[2] + boxMax[2]) };
+	double radius2 = 0.0;
+	for (size_t i = begin; i < end; ++i) {
+		Vec3 d = sub(position(pointData, indexData[i], dimensions, stride), center);
+		radius2 = std::max(radius2, dot(d, d));
+	}
+
+	// Normal cone: average of the unit triangle normals, opened as wide as
+	// the normal furthest from it
+	std::vector<Vec3> normals;
+	normals.reserve(meshlet.indexCount / 3);
+	Vec3 axis = { 0.0, 0.0, 0.0 };
+	for (size_t i = begin; i + 2 < end; i += 3) {
+		Vec3 a = position(pointData, indexData[i + 0], dimensions, stride);
+		Vec3 b = position(pointData, indexData[i + 1], dimensions, stride);
+		Vec3 c = position(pointData, indexData[i + 2], dimensions, stride);
+		Vec3 n = cross(sub(b, a), sub(c, a));
+		double length = std::sqrt(dot(n, n));
+		if (length == 0.0) continue; // degenerate triangles are never visible
+		n = { n[0] / length, n[1] / length, n[2] / length };
+		normals.push_back(n);
+		for (int k = 0; k < 3; ++k) axis[k] += n[k];
+	}
+
+	double axisLength = std::sqrt(dot(axis, axis));
+	double coneCutoff = 1.0;
+	if (axisLength > 0.0) {
+		axis = { axis[0] / axisLength, axis[1] / axisLength, axis[2] / axisLength };
+		double minDot = 1.0;
+		for (const Vec3& n : normals) minDot = std::min(minDot, dot(n, axis));
+		// Past 90 degrees, some triangle faces any point of view
+		if (minDot > 0.0) {
+			coneCutoff = std::sqrt(1.0 - minDot * minDot);
+		}
+	}
+
+	// Normals that cancel out (e.g. double-sided faces) leave no axis, and a
+	// cone that never culls needs none, but it stays a unit vector
+	if (coneCutoff >= 1.0) {
+		axis = { 0.0, 0.0, 1.0 };
+	}
+
+	for (int c = 0; c < 3; ++c) {
+		meshlet.center[c] = static_cast<float>(center[c]);
+		meshlet.coneAxis[c] = static_cast<float>(axis[c]);
+	}
+	meshlet.radius = static_cast<float>(std::sqrt(radius2));
+	meshlet.coneCutoff = static_cast<float>(coneCutoff);
+}
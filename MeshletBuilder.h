@@ -0,0 +1,65 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * A cluster of triangles, culled as a whole on the GPU (see cs_cull in
+ * culling.wgsl, which declares the same struct). Its triangles are the
+ * contiguous range [indexOffset, indexOffset + indexCount) of the mesh
+ * index buffer.
+ */
+struct Meshlet
+{
+	// Bounding sphere, in model space
+	std::array<float, 3> center;
+	float radius;
+	// Normal cone: the meshlet is back-facing from any point of view `p`
+	// such that dot(center - p, coneAxis) >= coneCutoff * |center - p| + radius.
+	// A cutoff of 1 means the cone is too wide to ever cull the meshlet, its
+	// axis is then (0, 0, 1). The axis is always a unit vector.
+	std::array<float, 3> coneAxis;
+	float coneCutoff;
+	uint32_t indexOffset;
+	uint32_t indexCount;
+	uint32_t _pad[2];
+};
+static_assert(sizeof(Meshlet) == 48, "Meshlet must match its WGSL counterpart");
+
+/**
+ * Split an index buffer into meshlets. Triangles are grouped greedily in
+ * the order they are drawn, which after MeshOptimizer is already spatially
+ * coherent, so the index buffer itself does not change.
+ *
+ * Points are interleaved floats, `stride` floats per vertex, the first
+ * `dimensions` of which are the position.
+ */
+class MeshletBuilder
+{
+public:
+	static constexpr size_t MaxVertices = 64;
+	static constexpr size_t MaxTriangles = 124;
+
+	/**
+	 * Return no meshlet if an index is out of range.
+	 */
+	static std::vector<Meshlet> build(
+		const std::vector<float>& pointData,
+		const std::vector<uint32_t>& indexData,
+		int dimensions,
+		int stride
+	);
+
+	/**
+	 * Fill the bounding sphere and normal cone of a meshlet whose index
+	 * range is already set.
+	 */
+	static void computeBounds(
+		Meshlet& meshlet,
+		const std::vector<float>& pointData,
+		const std::vector<uint32_t>& indexData,
+		int dimensions,
+		int stride
+	);
+};
@@ -0,0 +1,88 @@
+#include "PipelineLayoutCache.h"
+
+namespace
+{
+	std::vector<uint64_t> makeKey(const std::vector<WGPUBindGroupLayoutEntry>& entries)
+	{
+		std::vector<uint64_t> key;
+		key.reserve(entries.size() * 12);
+		for (const WGPUBindGroupLayoutEntry& entry : entries) {
+			key.push_back(entry.binding);
+			key.push_back(static_cast<uint64_t>(entry.visibility));
+			key.push_back(static_cast<uint64_t>(entry.buffer.type));
+			key.push_back(entry.buffer.hasDynamicOffset);
+			key.push_back(entry.buffer.minBindingSize);
+			key.push_back(static_cast<uint64_t>(entry.sampler.type));
+			key.push_back(static_cast<uint64_t>(entry.texture.sampleType));
+			key.push_back(static_cast<uint64_t>(entry.texture.viewDimension));
+			key.push_back(entry.texture.multisampled);
+			key.push_back(static_cast<uint64_t>(entry.storageTexture.access));
+			key.push_back(static_cast<uint64_t>(entry.storageTexture.format));
+			key.push_back(static_cast<uint64_t>(entry.storageTexture.viewDimension));
+		}
+		return key;
+	}
+}
+
+PipelineLayoutCache::PipelineLayoutCache(WGPUDevice device)
+	: m_device(device)
+{}
+
+PipelineLayoutCache::~PipelineLayoutCache()
+{
+	for (auto& [key, layout] : m_pipelineLayouts) {
+		wgpuPipelineLayoutRelease(layout);
+	}
+	for (auto& [key, layout] : m_bindGroupLayouts) {
+		wgpuBindGroupLayoutRelease(layout);
+	}
+}
+
+WGPUBindGroupLayout PipelineLayoutCache::bindGroupLayout(const std::vector<WGPUBindGroupLayoutEntry>& entries)
+{
+	WGPUBindGroupLayout& layout = m_bindGroupLayouts[makeKey(entries)];
+	if (layout == nullptr) {
+		WGPUBindGroupLayoutDescriptor bindGroupLayoutDesc = WGPU_BIND_GROUP_LAYOUT_DESCRIPTOR_INIT;
+		bindGroupLayoutDesc.entryCount = entries.size();
+		bindGroupLayoutDesc.entries = entries.data();
+		layout = wgpuDeviceCreateBindGroupLayout(m_device, &bindGroupLayoutDesc);
+	}
+	return layout;
+}
+
+WGPUPipelineLayout PipelineLayoutCache::pipelineLayout(const std::vector<WGPUBindGroupLayout>& bindGroupLayouts)
+{
+	WGPUPipelineLayout& layout = m_pipelineLayouts[bindGroupLayouts];
+	if (layout == nullptr) {
+		WGPUPipelineLayoutDescriptor layoutDesc = WGPU_PIPELINE_LAYOUT_DESCRIPTOR_INIT;
+		layoutDesc.bindGroupLayoutCount = bindGroupLayouts.size();
+		layoutDesc.bindGroupLayouts = bindGroupLayouts.data();
+		layout = wgpuDeviceCreatePipelineLayout(m_device, &layoutDesc);
+	}
+	return layout;
+}
+
+void PipelineLayoutCache::setDynamicOffset(uint32_t group, uint32_t binding)
+{
+	m_dynamicBindings.insert({ group, binding });
+}
+
+WGPUBindGroupLayout PipelineLayoutCache::bindGroupLayout(const ShaderReflection& reflection, uint32_t group)
+{
+	std::vector<WGPUBindGroupLayoutEntry> entries = reflection.bindGroupLayoutEntries(group);
+	for (WGPUBindGroupLayoutEntry& entry : entries) {
+		if (entry.buffer.type != WGPUBufferBindingType_BindingNotUsed && m_dynamicBindings.count({ group, entry.binding }) > 0) {
+			entry.buffer.hasDynamicOffset = true;
+		}
+	}
+	return bindGroupLayout(entries);
+}
+
+WGPUPipelineLayout PipelineLayoutCache::pipelineLayout(const ShaderReflection& reflection, const std::vector<std::string>& entryPoints)
+{
+	std::vector<WGPUBindGroupLayout> bindGroupLayouts(reflection.bindGroupCount(entryPoints));
+	for (uint32_t group = 0; group < bindGroupLayouts.size(); ++group) {
+		bindGroupLayouts[group] = bindGroupLayout(reflection, group);
+	}
+	return pipelineLayout(bindGroupLayouts);
+}
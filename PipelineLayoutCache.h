@@ -0,0 +1,64 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+#include <webgpu/webgpu.h>
+#include "ShaderReflection.h"
+
+/**
+ * Bind group and pipeline layouts of a device, created once per distinct
+ * content. Pipelines whose shaders declare the same bindings therefore
+ * share their layouts, and bind groups created for one of them can be used
+ * with the others.
+ *
+ * Layouts are few and small, so they are owned by the cache and live as
+ * long as it does: the handles it returns are borrowed and must not be
+ * released. Only used from the render thread.
+ */
+class PipelineLayoutCache
+{
+public:
+	explicit PipelineLayoutCache(WGPUDevice device);
+	~PipelineLayoutCache();
+
+	PipelineLayoutCache(const PipelineLayoutCache&) = delete;
+	PipelineLayoutCache& operator=(const PipelineLayoutCache&) = delete;
+
+	WGPUBindGroupLayout bindGroupLayout(const std::vector<WGPUBindGroupLayoutEntry>& entries);
+
+	WGPUPipelineLayout pipelineLayout(const std::vector<WGPUBindGroupLayout>& bindGroupLayouts);
+
+	/**
+	 * Bind the buffer at `binding` of `group` with a dynamic offset in the
+	 * layouts generated from reflected shaders from now on, which WGSL
+	 * cannot express.
+	 */
+	void setDynamicOffset(uint32_t group, uint32_t binding);
+
+	/**
+	 * Bind group layout of `group` as declared by a reflected shader.
+	 */
+	WGPUBindGroupLayout bindGroupLayout(const ShaderReflection& reflection, uint32_t group);
+
+	/**
+	 * Layout of a pipeline made of `entryPoints` of a reflected shader. Each
+	 * group has the layout it has for the whole module, so that it is the
+	 * same for all the pipelines of the module.
+	 */
+	WGPUPipelineLayout pipelineLayout(const ShaderReflection& reflection, const std::vector<std::string>& entryPoints);
+
+	size_t bindGroupLayoutCount() const { return m_bindGroupLayouts.size(); }
+	size_t pipelineLayoutCount() const { return m_pipelineLayouts.size(); }
+
+private:
+	WGPUDevice m_device;
+	// Keyed by the fields of the entries that WebGPU compares
+	std::map<std::vector<uint64_t>, WGPUBindGroupLayout> m_bindGroupLayouts;
+	std::map<std::vector<WGPUBindGroupLayout>, WGPUPipelineLayout> m_pipelineLayouts;
+	// (group, binding)
+	std::set<std::pair<uint32_t, uint32_t>> m_dynamicBindings;
+};
@@ -0,0 +1,314 @@
+#include "RenderPipelineCache.h"
+#include "Hash.h"
+#include "webgpu-utils.h"
+
+#include <array>
+#include <iostream>
+#include <utility>
+
+namespace
+{
+	bool sameBlendComponent(const WGPUBlendComponent& a, const WGPUBlendComponent& b)
+	{
+		return a.operation == b.operation && a.srcFactor == b.srcFactor && a.dstFactor == b.dstFactor;
+	}
+
+	void hashBlendComponent(Hasher& hasher, const WGPUBlendComponent& component)
+	{
+		hasher.updateValue(static_cast<uint32_t>(component.operation));
+		hasher.updateValue(static_cast<uint32_t>(component.srcFactor));
+		hasher.updateValue(static_cast<uint32_t>(component.dstFactor));
+	}
+
+	void hashConstants(Hasher& hasher, const std::vector<PipelineConstant>& constants)
+	{
+		hasher.updateValue(static_cast<uint32_t>(constants.size()));
+		for (const PipelineConstant& constant : constants) {
+			hasher.updateString(constant.key);
+			hasher.updateValue(constant.value);
+		}
+	}
+
+	// Point into `constants`, which must outlive the entries
+	std::vector<WGPUConstantEntry> constantEntries(const std::vector<PipelineConstant>& constants)
+	{
+		std::vector<WGPUConstantEntry> entries(constants.size(), WGPU_CONSTANT_ENTRY_INIT);
+		for (size_t i = 0; i < constants.size(); ++i) {
+			entries[i].key = toWgpuStringView(constants[i].key);
+			entries[i].value = constants[i].value;
+		}
+		return entries;
+	}
+
+	/**
+	 * Descriptor of the pipeline for a state, with everything it points to.
+	 * Filled in place since it points into itself.
+	 */
+	struct PipelineDescriptor
+	{
+		WGPURenderPipelineDescriptor pipeline = WGPU_RENDER_PIPELINE_DESCRIPTOR_INIT;
+		std::array<WGPUVertexAttribute, 2> vertexAttribs;
+		WGPUVertexBufferLayout vertexBufferLayout;
+		std::vector<WGPUConstantEntry> vertexConstants;
+		std::vector<WGPUConstantEntry> fragmentConstants;
+		WGPUDepthStencilState depthStencil = WGPU_DEPTH_STENCIL_STATE_INIT;
+		WGPUFragmentState fragment = WGPU_FRAGMENT_STATE_INIT;
+		WGPUColorTargetState colorTarget = WGPU_COLOR_TARGET_STATE_INIT;
+
+		explicit PipelineDescriptor(const RenderPipelineState& state)
+		{
+			if (!state.label.empty()) pipeline.label = toWgpuStringView(state.label);
+
+			// Vertex fetch: position and color, in whichever format the
+			// geometry was encoded with (see VertexLayout and VertexQuantizer)
+			vertexBufferLayout = state.vertexLayout.bufferLayout(vertexAttribs);
+			pipeline.vertex.bufferCount = 1;
+			pipeline.vertex.buffers = &vertexBufferLayout;
+			pipeline.vertex.module = state.shaderModule;
+			pipeline.vertex.entryPoint = toWgpuStringView(state.vertexEntryPoint);
+			vertexConstants = constantEntries(state.vertexConstants);
+			pipeline.vertex.constantCount = vertexConstants.size();
+			pipeline.vertex.constants = vertexConstants.data();
+
+			pipeline.primitive.topology = state.topology;
+			pipeline.primitive.frontFace = state.frontFace;
+			pipeline.primitive.cullMode = state.cullMode;
+
+			if (state.depthFormat != WGPUTextureFormat_Undefined) {
+				depthStencil.format = state.depthFormat;
+				depthStencil.depthCompare = state.depthCompare;
+				depthStencil.depthWriteEnabled = state.depthWriteEnabled ? WGPUOptionalBool_True : WGPUOptionalBool_False;
+				pipeline.depthStencil = &depthStencil;
+			}
+
+			pipeline.multisample.count = state.sampleCount;
+
+			fragment.module = state.shaderModule;
+			fragment.entryPoint = toWgpuStringView(state.fragmentEntryPoint);
+			fragmentConstants = constantEntries(state.fragmentConstants);
+			fragment.constantCount = fragmentConstants.size();
+			fragment.constants = fragmentConstants.data();
+			colorTarget.format = state.colorFormat;
+			colorTarget.blend = state.blendEnabled ? &state.blend : nullptr;
+			fragment.targetCount = 1;
+			fragment.targets = &colorTarget;
+			pipeline.fragment = &fragment;
+
+			pipeline.layout = state.layout;
+		}
+
+		PipelineDescriptor(const PipelineDescriptor&) = delete;
+		PipelineDescriptor& operator=(const PipelineDescriptor&) = delete;
+	};
+}
+
+bool RenderPipelineState::operator==(const RenderPipelineState& other) const
+{
+	// The blend state only matters when blending is enabled
+	bool sameBlend = blendEnabled == other.blendEnabled
+		&& (!blendEnabled || (sameBlendComponent(blend.color, other.blend.color) && sameBlendComponent(blend.alpha, other.blend.alpha)));
+	return shaderModule == other.shaderModule
+		&& vertexEntryPoint == other.vertexEntryPoint
+		&& fragmentEntryPoint == other.fragmentEntryPoint
+		&& vertexConstants == other.vertexConstants
+		&& fragmentConstants == other.fragmentConstants
+		&& layout == other.layout
+		&& vertexLayout.sameFormat(other.vertexLayout)
+		&& topology == other.topology
+		&& frontFace == other.frontFace
+		&& cullMode == other.cullMode
+		&& colorFormat == other.colorFormat
+		&& sameBlend
+		&& depthFormat == other.depthFormat
+		&& depthCompare == other.depthCompare
+		&& depthWriteEnabled == other.depthWriteEnabled
+		&& sampleCount == other.sampleCount;
+}
+
+uint64_t RenderPipelineState::hash() const
+{
+	// Field by field, since the structs have padding and fields that are not
+	// part of the key. Must agree with operator==.
+	Hasher hasher;
+	hasher.updateValue(reinterpret_cast<uintptr_t>(shaderModule));
+	hasher.updateString(vertexEntryPoint);
+	hasher.updateString(fragmentEntryPoint);
+	hashConstants(hasher, vertexConstants);
+	hashConstants(hasher, fragmentConstants);
+	hasher.updateValue(reinterpret_cast<uintptr_t>(layout));
+	hasher.updateValue(static_cast<uint32_t>(vertexLayout.positionFormat));
+	hasher.updateValue(static_cast<uint32_t>(vertexLayout.colorFormat));
+	hasher.updateValue(vertexLayout.positionOffset);
+	hasher.updateValue(vertexLayout.colorOffset);
+	hasher.updateValue(vertexLayout.stride);
+	hasher.updateValue(static_cast<uint32_t>(topology));
+	hasher.updateValue(static_cast<uint32_t>(frontFace));
+	hasher.updateValue(static_cast<uint32_t>(cullMode));
+	hasher.updateValue(static_cast<uint32_t>(colorFormat));
+	hasher.updateValue(static_cast<uint8_t>(blendEnabled));
+	if (blendEnabled) {
+		hashBlendComponent(hasher, blend.color);
+		hashBlendComponent(hasher, blend.alpha);
+	}
+	hasher.updateValue(static_cast<uint32_t>(depthFormat));
+	hasher.updateValue(static_cast<uint32_t>(depthCompare));
+	hasher.updateValue(static_cast<uint8_t>(depthWriteEnabled));
+	hasher.updateValue(sampleCount);
+	return hasher.digest();
+}
+
+RenderPipelineCache::RenderPipelineCache(WGPUDevice device)
+	: m_device(device)
+{}
+
+RenderPipelineCache::~RenderPipelineCache()
+{
+	// Pipelines still compiling are released when they are done
+	*m_alive = false;
+	for (auto& [key, entry] : m_entries) {
+		releaseEntry(entry);
+	}
+}
+
+WGPURenderPipeline RenderPipelineCache::acquire(const RenderPipelineState& state)
+{
+	if (state.shaderModule == nullptr) return nullptr;
+
+	const uint64_t key = state.hash();
+	auto range = m_entries.equal_range(key);
+	for (auto it = range.first; it != range.second; ++it) {
+		Entry& entry = it->second;
+		// A pipeline still compiling cannot be waited for here, so it is
+		// created again
+		if (entry.pipeline != nullptr && entry.state == state) {
+			++entry.refCount;
+			++m_hitCount;
+			return entry.pipeline;
+		}
+	}
+
+	++m_missCount;
+	PipelineDescriptor descriptor(state);
+	WGPURenderPipeline pipeline = wgpuDeviceCreateRenderPipeline(m_device, &descriptor.pipeline);
+	if (pipeline == nullptr) return nullptr;
+	insert(key, state, pipeline).refCount = 1;
+	return pipeline;
+}
+
+void RenderPipelineCache::acquireAsync(const RenderPipelineState& state, std::function<void(WGPURenderPipeline)> onReady)
+{
+	if (state.shaderModule == nullptr) {
+		onReady(nullptr);
+		return;
+	}
+
+	const uint64_t key = state.hash();
+	auto range = m_entries.equal_range(key);
+	for (auto it = range.first; it != range.second; ++it) {
+		Entry& entry = it->second;
+		if (!(entry.state == state)) continue;
+		++m_hitCount;
+		if (entry.pipeline == nullptr) {
+			entry.waiters.push_back(std::move(onReady));
+		}
+		else {
+			++entry.refCount;
+			onReady(entry.pipeline);
+		}
+		return;
+	}
+
+	++m_missCount;
+	++m_pendingCount;
+	Entry& entry = insert(key, state, nullptr);
+	entry.waiters.push_back(std::move(onReady));
+
+	PipelineDescriptor descriptor(state);
+	WGPUCreateRenderPipelineAsyncCallbackInfo callbackInfo = WGPU_CREATE_RENDER_PIPELINE_ASYNC_CALLBACK_INFO_INIT;
+	callbackInfo.mode = WGPUCallbackMode_AllowProcessEvents;
+	callbackInfo.callback = [](
+		WGPUCreatePipelineAsyncStatus status,
+		WGPURenderPipeline pipeline,
+		WGPUStringView message,
+		void* userdata1,
+		void* /* userdata2 */
+		) {
+			std::unique_ptr<Request> request(static_cast<Request*>(userdata1));
+			if (status != WGPUCreatePipelineAsyncStatus_Success) {
+				std::cerr << "Could not create render pipeline: " << toStdStringView(message) << std::endl;
+				if (pipeline) wgpuRenderPipelineRelease(pipeline);
+				pipeline = nullptr;
+			}
+			if (!*request->alive) {
+				if (pipeline) wgpuRenderPipelineRelease(pipeline);
+				return;
+			}
+			request->cache->finishAsync(*request, pipeline);
+		};
+	callbackInfo.userdata1 = new Request{ this, m_alive, key, &entry };
+	wgpuDeviceCreateRenderPipelineAsync(m_device, &descriptor.pipeline, callbackInfo);
+}
+
+RenderPipelineCache::Entry& RenderPipelineCache::insert(uint64_t key, const RenderPipelineState& state, WGPURenderPipeline pipeline)
+{
+	// Keep the handles of the key alive, see class comment
+	wgpuShaderModuleAddRef(state.shaderModule);
+	if (state.layout) wgpuPipelineLayoutAddRef(state.layout);
+
+	Entry entry;
+	entry.state = state;
+	entry.pipeline = pipeline;
+	if (pipeline) m_keys[pipeline] = key;
+	return m_entries.emplace(key, std::move(entry))->second;
+}
+
+void RenderPipelineCache::finishAsync(const Request& request, WGPURenderPipeline pipeline)
+{
+	--m_pendingCount;
+	auto range = m_entries.equal_range(request.key);
+	auto it = range.first;
+	while (it != range.second && &it->second != request.entry) ++it;
+	std::vector<std::function<void(WGPURenderPipeline)>> waiters = std::move(it->second.waiters);
+
+	if (pipeline == nullptr) {
+		// Forget the state, so that asking for it again retries
+		releaseEntry(it->second);
+		m_entries.erase(it);
+	}
+	else {
+		it->second.pipeline = pipeline;
+		it->second.refCount = static_cast<uint32_t>(waiters.size());
+		m_keys[pipeline] = request.key;
+	}
+
+	// Last, since waiters may use the cache
+	for (auto& onReady : waiters) {
+		onReady(pipeline);
+	}
+}
+
+void RenderPipelineCache::release(WGPURenderPipeline pipeline)
+{
+	auto keyIt = m_keys.find(pipeline);
+	if (keyIt == m_keys.end()) {
+		std::cerr << "Releasing render pipeline " << pipeline << " that is not in the cache" << std::endl;
+		return;
+	}
+	auto range = m_entries.equal_range(keyIt->second);
+	for (auto it = range.first; it != range.second; ++it) {
+		if (it->second.pipeline != pipeline) continue;
+		if (--it->second.refCount == 0) {
+			releaseEntry(it->second);
+			m_entries.erase(it);
+			m_keys.erase(keyIt);
+		}
+		return;
+	}
+}
+
+void RenderPipelineCache::releaseEntry(const Entry& entry)
+{
+	if (entry.pipeline) wgpuRenderPipelineRelease(entry.pipeline);
+	wgpuShaderModuleRelease(entry.state.shaderModule);
+	if (entry.state.layout) wgpuPipelineLayoutRelease(entry.state.layout);
+}
@@ -0,0 +1,138 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <webgpu/webgpu.h>
+#include "Geometry.h"
+#include "ShaderReflection.h"
+
+/**
+ * Everything a render pipeline is created from. Two equal states always
+ * produce interchangeable pipelines, so the state is the cache key.
+ */
+struct RenderPipelineState
+{
+	// Variant of the shader, as returned by the ShaderModuleCache
+	WGPUShaderModule shaderModule = nullptr;
+	std::string vertexEntryPoint = "vs_main";
+	std::string fragmentEntryPoint = "fs_main";
+	// Values of the overrides each stage uses, in a stable order (see
+	// ShaderReflection::stageConstants()), so that specialized variants of
+	// a module are distinct pipelines
+	std::vector<PipelineConstant> vertexConstants;
+	std::vector<PipelineConstant> fragmentConstants;
+	WGPUPipelineLayout layout = nullptr;
+	// Only the vertex format matters, not the dequantization
+	VertexLayout vertexLayout;
+	WGPUPrimitiveTopology topology = WGPUPrimitiveTopology_TriangleList;
+	WGPUFrontFace frontFace = WGPUFrontFace_CCW;
+	WGPUCullMode cullMode = WGPUCullMode_None;
+	WGPUTextureFormat colorFormat = WGPUTextureFormat_Undefined;
+	// No blending (the target is replaced) when disabled
+	bool blendEnabled = false;
+	WGPUBlendState blend = WGPU_BLEND_STATE_INIT;
+	// No depth buffer when undefined
+	WGPUTextureFormat depthFormat = WGPUTextureFormat_Undefined;
+	WGPUCompareFunction depthCompare = WGPUCompareFunction_Less;
+	bool depthWriteEnabled = true;
+	uint32_t sampleCount = 1;
+	// Names the pipeline when it is created, not part of the key
+	std::string label;
+
+	bool operator==(const RenderPipelineState& other) const;
+	uint64_t hash() const;
+};
+
+/**
+ * Render pipelines of a device, deduplicated by state: asking twice for the
+ * same RenderPipelineState returns the same WGPURenderPipeline instead of
+ * compiling it again, e.g. when a reloaded geometry keeps its encoding or a
+ * reloaded shader preprocesses to the same source.
+ *
+ * Pipelines are reference counted like shader modules (see
+ * ShaderModuleCache), and each one holds a reference to its shader module
+ * and layout, so that their handles cannot be reused for other objects
+ * while the pipeline is in the cache. Only used from the render thread.
+ *
+ * Compiling a pipeline can take long enough to drop frames, so pipelines
+ * can also be created in the background with acquireAsync().
+ */
+class RenderPipelineCache
+{
+public:
+	explicit RenderPipelineCache(WGPUDevice device);
+	// Release every pipeline, whether or not they were all released
+	~RenderPipelineCache();
+
+	RenderPipelineCache(const RenderPipelineCache&) = delete;
+	RenderPipelineCache& operator=(const RenderPipelineCache&) = delete;
+
+	/**
+	 * Pipeline built from `state`, created on first use. Return null if the
+	 * state has no shader module, in which case nothing needs releasing.
+	 */
+	WGPURenderPipeline acquire(const RenderPipelineState& state);
+
+	/**
+	 * Same as acquire() without blocking: `onReady` is called with the
+	 * pipeline once it is compiled, from wgpuInstanceProcessEvents(), or
+	 * right away if it is already in the cache. Requests for a state that
+	 * is still compiling wait for the same pipeline. The pipeline is null if
+	 * it could not be created, which has already been reported, and must be
+	 * released otherwise.
+	 */
+	void acquireAsync(const RenderPipelineState& state, std::function<void(WGPURenderPipeline)> onReady);
+
+	/**
+	 * Drop a reference, and the pipeline itself with the last one.
+	 */
+	void release(WGPURenderPipeline pipeline);
+
+	// Number of distinct pipelines alive or compiling
+	size_t size() const { return m_entries.size(); }
+	// Number of pipelines compiling in the background
+	size_t pendingCount() const { return m_pendingCount; }
+	// Number of acquire() calls served without creating a pipeline
+	uint64_t hitCount() const { return m_hitCount; }
+	uint64_t missCount() const { return m_missCount; }
+
+private:
+	struct Entry
+	{
+		// Compared on lookup, so that a hash collision can never hand out
+		// the wrong pipeline
+		RenderPipelineState state;
+		// Null while compiling in the background
+		WGPURenderPipeline pipeline = nullptr;
+		uint32_t refCount = 0;
+		// Each one gets a reference once the pipeline is compiled
+		std::vector<std::function<void(WGPURenderPipeline)>> waiters;
+	};
+
+	// A background compilation, owned by its callback
+	struct Request
+	{
+		RenderPipelineCache* cache;
+		// Cleared when the cache is destroyed first
+		std::shared_ptr<bool> alive;
+		uint64_t key;
+		// Elements of an unordered container keep their address
+		Entry* entry;
+	};
+
+	Entry& insert(uint64_t key, const RenderPipelineState& state, WGPURenderPipeline pipeline);
+	void finishAsync(const Request& request, WGPURenderPipeline pipeline);
+	static void releaseEntry(const Entry& entry);
+
+	WGPUDevice m_device;
+	std::unordered_multimap<uint64_t, Entry> m_entries;
+	std::unordered_map<WGPURenderPipeline, uint64_t> m_keys;
+	std::shared_ptr<bool> m_alive = std::make_shared<bool>(true);
+	size_t m_pendingCount = 0;
+	uint64_t m_hitCount = 0;
+	uint64_t m_missCount = 0;
+};
@@ -0,0 +1,166 @@
+#include "ResourceLoader.h"
+#include "ResourceManager.h"
+
+#include <algorithm>
+#include <utility>
+
+ResourceLoader::ResourceLoader(unsigned threadCount)
+{
+#ifdef RESOURCE_LOADER_THREADS
+	threadCount = std::max(threadCount, 1u);
+	for (unsigned i = 0; i < threadCount; ++i) {
+		m_workers.emplace_back(&ResourceLoader::workerMain, this);
+	}
+#else
+	(void)threadCount;
+#endif
+}
+
+ResourceLoader::~ResourceLoader()
+{
+#ifdef RESOURCE_LOADER_THREADS
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stopping = true;
+		m_jobs.clear();
+	}
+	m_jobAvailable.notify_all();
+	for (std::thread& worker : m_workers) {
+		worker.join();
+	}
+#endif
+}
+
+GeometryHandle ResourceLoader::loadGeometry(
+	const std::filesystem::path& path,
+	int dimensions,
+	GeometryProcessing processing,
+	std::function<void(LoadHandle<Geometry>&)> onComplete
+)
+{
+	return submit<Geometry>(
+		path,
+		[path, dimensions, processing](Geometry& geometry) {
+			return ResourceManager::loadGeometry(path, geometry, dimensions, processing);
+		},
+		std::move(onComplete)
+	);
+}
+
+GeometrySourceHandle ResourceLoader::openGeometry(
+	const std::filesystem::path& path,
+	int dimensions,
+	GeometryProcessing processing,
+	std::function<void(LoadHandle<GeometrySource>&)> onComplete
+)
+{
+	return submit<GeometrySource>(
+		path,
+		[path, dimensions, processing](GeometrySource& source) {
+			return ResourceManager::openGeometry(path, source, dimensions, processing);
+		},
+		std::move(onComplete)
+	);
+}
+
+PreprocessedShaderHandle ResourceLoader::loadShader(
+	const std::filesystem::path& path,
+	ShaderFeatures features,
+	std::function<void(LoadHandle<PreprocessedShader>&)> onComplete
+)
+{
+	return submit<PreprocessedShader>(
+		path,
+		[path, features](PreprocessedShader& shader) {
+			return ShaderPreprocessor::preprocess(path, ShaderPreprocessor::definesFor(features), shader);
+		},
+		std::move(onComplete)
+	);
+}
+
+template <typename T>
+std::shared_ptr<LoadHandle<T>> ResourceLoader::submit(
+	const std::filesystem::path& path,
+	std::function<bool(T&)> work,
+	std::function<void(LoadHandle<T>&)> onComplete
+)
+{
+	auto handle = std::make_shared<LoadHandle<T>>();
+	handle->m_path = path;
+	handle->m_onComplete = std::move(onComplete);
+
+	Job job;
+	// The worker only touches m_value and m_succeeded, which the render
+	// thread does not read before the completion is dispatched.
+	job.work = [handle, work = std::move(work)]() {
+		handle->m_succeeded = work(handle->m_value);
+	};
+	job.complete = [handle]() {
+		handle->m_state = handle->m_succeeded ? LoadHandle<T>::State::Ready : LoadHandle<T>::State::Failed;
+		if (handle->m_onComplete) {
+			handle->m_onComplete(*handle);
+			handle->m_onComplete = nullptr;
+		}
+	};
+	enqueue(std::move(job));
+	return handle;
+}
+
+void ResourceLoader::enqueue(Job&& job)
+{
+	++m_pendingCount;
+#ifdef RESOURCE_LOADER_THREADS
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_jobs.push_back(std::move(job));
+	}
+	m_jobAvailable.notify_one();
+#else
+	m_jobs.push_back(std::move(job));
+#endif
+}
+
+size_t ResourceLoader::dispatchCompletions()
+{
+#ifdef RESOURCE_LOADER_THREADS
+	std::vector<std::function<void()>> completed;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		completed.swap(m_completed);
+	}
+	for (const auto& complete : completed) {
+		complete();
+	}
+	m_pendingCount -= completed.size();
+	return completed.size();
+#else
+	if (m_jobs.empty()) return 0;
+	Job job = std::move(m_jobs.front());
+	m_jobs.pop_front();
+	job.work();
+	job.complete();
+	--m_pendingCount;
+	return 1;
+#endif
+}
+
+#ifdef RESOURCE_LOADER_THREADS
+void ResourceLoader::workerMain()
+{
+	for (;;) {
+		Job job;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_jobAvailable.wait(lock, [this]() { return m_stopping || !m_jobs.empty(); });
+			if (m_stopping) return;
+			job = std::move(m_jobs.front());
+			m_jobs.pop_front();
+		}
+
+		job.work();
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_completed.push_back(std::move(job.complete));
+	}
+}
+#endif
@@ -0,0 +1,147 @@
+#pragma once
+#include <cstddef>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include "Geometry.h"
+#include "ResourceManager.h"
+#include "ShaderPreprocessor.h"
+
+#if !defined(__EMSCRIPTEN__) || defined(__EMSCRIPTEN_PTHREADS__)
+#  define RESOURCE_LOADER_THREADS
+#  include <condition_variable>
+#  include <mutex>
+#  include <thread>
+#endif
+
+/**
+ * A resource being loaded by the ResourceLoader. It is only ever updated on
+ * the thread calling ResourceLoader::dispatchCompletions(), so it can be
+ * polled from the render thread without synchronization.
+ */
+template <typename T>
+class LoadHandle
+{
+public:
+	enum class State { Pending, Ready, Failed };
+
+	State state() const { return m_state; }
+	bool isPending() const { return m_state == State::Pending; }
+	bool isReady() const { return m_state == State::Ready; }
+	bool hasFailed() const { return m_state == State::Failed; }
+
+	const std::filesystem::path& path() const { return m_path; }
+
+	// Only meaningful once ready
+	T& value() { return m_value; }
+	const T& value() const { return m_value; }
+
+private:
+	friend class ResourceLoader;
+	std::filesystem::path m_path;
+	T m_value = {};
+	State m_state = State::Pending;
+	// Set by the worker, published to the render thread with the completion
+	bool m_succeeded = false;
+	std::function<void(LoadHandle&)> m_onComplete;
+};
+
+using GeometryHandle = std::shared_ptr<LoadHandle<Geometry>>;
+using GeometrySourceHandle = std::shared_ptr<LoadHandle<GeometrySource>>;
+using PreprocessedShaderHandle = std::shared_ptr<LoadHandle<PreprocessedShader>>;
+
+/**
+ * Asynchronous front end to the ResourceManager: file I/O, parsing and
+ * post-load processing run on a pool of worker threads, while completion
+ * callbacks run on the thread calling dispatchCompletions(), typically the
+ * render thread at a frame boundary, which is where GPU uploads belong.
+ *
+ * Without thread support (Emscripten without pthreads), jobs run one at a
+ * time from dispatchCompletions() instead, so frames still get presented
+ * between two loads.
+ */
+class ResourceLoader
+{
+public:
+	static constexpr unsigned DefaultThreadCount = 2;
+
+	explicit ResourceLoader(unsigned threadCount = DefaultThreadCount);
+	// Wait for the jobs that are running and drop the others
+	~ResourceLoader();
+
+	ResourceLoader(const ResourceLoader&) = delete;
+	ResourceLoader& operator=(const ResourceLoader&) = delete;
+
+	/**
+	 * Load geometry through ResourceManager::loadGeometry().
+	 */
+	GeometryHandle loadGeometry(
+		const std::filesystem::path& path,
+		int dimensions,
+		GeometryProcessing processing,
+		std::function<void(LoadHandle<Geometry>&)> onComplete = nullptr
+	);
+
+	/**
+	 * Open geometry through ResourceManager::openGeometry(). A streamer is
+	 * only opened on the worker, chunks are left to the completion callback.
+	 */
+	GeometrySourceHandle openGeometry(
+		const std::filesystem::path& path,
+		int dimensions,
+		GeometryProcessing processing,
+		std::function<void(LoadHandle<GeometrySource>&)> onComplete = nullptr
+	);
+
+	/**
+	 * Read and preprocess the variant of a shader with `features` (see
+	 * ShaderPreprocessor), along with the files it includes.
+	 */
+	PreprocessedShaderHandle loadShader(
+		const std::filesystem::path& path,
+		ShaderFeatures features,
+		std::function<void(LoadHandle<PreprocessedShader>&)> onComplete = nullptr
+	);
+
+	/**
+	 * Mark finished jobs as ready (or failed) and run their callbacks on the
+	 * calling thread. Return the number of completed jobs.
+	 */
+	size_t dispatchCompletions();
+
+	// Number of jobs not dispatched yet
+	size_t pendingCount() const { return m_pendingCount; }
+
+private:
+	struct Job {
+		// Runs on a worker
+		std::function<void()> work;
+		// Runs in dispatchCompletions()
+		std::function<void()> complete;
+	};
+
+	template <typename T>
+	std::shared_ptr<LoadHandle<T>> submit(
+		const std::filesystem::path& path,
+		std::function<bool(T&)> work,
+		std::function<void(LoadHandle<T>&)> onComplete
+	);
+
+	void enqueue(Job&& job);
+
+private:
+	std::deque<Job> m_jobs;
+	size_t m_pendingCount = 0;
+#ifdef RESOURCE_LOADER_THREADS
+	void workerMain();
+
+	std::vector<std::function<void()>> m_completed;
+	std::vector<std::thread> m_workers;
+	std::mutex m_mutex;
+	std::condition_variable m_jobAvailable;
+	bool m_stopping = false;
+#endif
+};
@@ -1,85 +1,252 @@
-#include <fstream>
-#include <sstream>
+#include <mutex>
 #include <string>
 #include <iostream>
 #include "ResourceManager.h"
+#include "Geometry.h"
+#include "GeometryParser.h"
+#include "MappedFile.h"
+#include "MeshCache.h"
+#include "MeshOptimizer.h"
+#include "MeshletBuilder.h"
+#include "MeshSimplifier.h"
+#include "ResourcePack.h"
+#include "VertexQuantizer.h"
 #include "webgpu-utils.h"
 
-bool ResourceManager::loadGeometry(const std::filesystem::path& path, std::vector<float>& pointData, std::vector<uint16_t>& indexData, int dimensions)
+namespace
 {
-	std::ifstream file(path);
-	if (!file.is_open()) {
-		std::cerr << "Could not load geometry!" << std::endl;
+	struct MountedPack
+	{
+		std::filesystem::path mountPoint;
+		std::shared_ptr<const ResourcePack> pack;
+	};
+	std::mutex packMutex;
+	std::vector<MountedPack> mountedPacks;
+
+	template <typename Index>
+	void parseGeometry(const ResourceData& file, std::vector<float>& pointData, std::vector<Index>& indexData, int dimensions, MeshBounds* bounds)
+	{
+		// Tokenize the mapped file in place rather than going through an
+		// std::istringstream per line. Large files are split across threads.
+		std::string_view text = file.text();
+		GeometryParser::parse(text.data(), text.data() + text.size(), pointData, indexData, dimensions, 0, bounds);
+	}
+
+	template <typename Index>
+	bool loadGeometryImpl(const std::filesystem::path& path, std::vector<float>& pointData, std::vector<Index>& indexData, int dimensions, MeshBounds* bounds)
+	{
+		ResourceData file;
+		if (!ResourceManager::loadResource(path, file)) {
+			std::cerr << "Could not load geometry!" << std::endl;
+			return false;
+		}
+		parseGeometry(file, pointData, indexData, dimensions, bounds);
+		return true;
+	}
+}
+
+bool ResourceManager::mountPack(const std::filesystem::path& packPath, const std::filesystem::path& mountPoint)
+{
+	auto pack = std::make_shared<ResourcePack>();
+	if (!pack->open(packPath)) {
+		std::cerr << "Could not mount resource pack " << packPath << "!" << std::endl;
 		return false;
 	}
+	std::lock_guard<std::mutex> lock(packMutex);
+	// Packs mounted last take precedence
+	mountedPacks.insert(mountedPacks.begin(), { mountPoint.lexically_normal(), std::move(pack) });
+	return true;
+}
 
-	pointData.clear();
-	indexData.clear();
+void ResourceManager::unmountPacks()
+{
+	// Resources loaded from the packs keep them mapped until released
+	std::lock_guard<std::mutex> lock(packMutex);
+	mountedPacks.clear();
+}
 
-	enum class Section {
-		None,
-		Points,
-		Indices,
-	};
-	Section currentSection = Section::None;
+bool ResourceManager::loadResource(const std::filesystem::path& path, ResourceData& data)
+{
+	data = ResourceData();
+	std::vector<MountedPack> packs;
+	{
+		std::lock_guard<std::mutex> lock(packMutex);
+		packs = mountedPacks;
+	}
 
-	float value;
-	uint16_t index;
-	std::string line;
-	while (!file.eof()) {
-		getline(file, line);
+	const std::filesystem::path normalPath = path.lexically_normal();
+	for (const MountedPack& mounted : packs) {
+		std::filesystem::path relativePath = normalPath.lexically_relative(mounted.mountPoint);
+		if (relativePath.empty() || *relativePath.begin() == "..") continue;
+		const ResourcePack::Entry* entry = mounted.pack->find(relativePath.generic_string());
+		if (entry == nullptr) continue;
 
-		// overcome the `CRLF` problem
-		if (!line.empty() && line.back() == '\r') {
-			line.pop_back();
+		data.m_pack = mounted.pack;
+		if (!mounted.pack->view(*entry, data.m_view)) {
+			if (!mounted.pack->read(*entry, data.m_copy)) return false;
+			data.m_view = { data.m_copy.data(), data.m_copy.size() };
 		}
+		return true;
+	}
+
+	if (!data.m_file.open(path)) return false;
+	data.m_view = { data.m_file.data(), data.m_file.size() };
+	return true;
+}
+
+bool ResourceManager::loadGeometry(const std::filesystem::path& path, std::vector<float>& pointData, std::vector<uint16_t>& indexData, int dimensions, MeshBounds* bounds)
+{
+	return loadGeometryImpl(path, pointData, indexData, dimensions, bounds);
+}
+
+bool ResourceManager::loadGeometry(const std::filesystem::path& path, std::vector<float>& pointData, std::vector<uint32_t>& indexData, int dimensions, MeshBounds* bounds)
+{
+	return loadGeometryImpl(path, pointData, indexData, dimensions, bounds);
+}
+
+bool ResourceManager::loadGeometry(const std::filesystem::path& path, Geometry& geometry, int dimensions, GeometryProcessing processing)
+{
+	// Checked before anything is parsed with the wrong stride
+	VertexLayout floatLayout;
+	if (!VertexLayout::floatLayout(dimensions, floatLayout)) {
+		std::cerr << "Could not load geometry!" << std::endl;
+		return false;
+	}
 
-		if (line == "[points]") {
-			currentSection = Section::Points;
+	ResourceData file;
+	if (!loadResource(path, file)) {
+		std::cerr << "Could not load geometry!" << std::endl;
+		return false;
+	}
+
+	// The cache is keyed by the content of the file, hashing it is much
+	// cheaper than parsing it
+	MeshCache::Key cacheKey = MeshCache::makeKey(file.data(), file.size(), dimensions, processing);
+	if (MeshCache::read(cacheKey, geometry)) {
+		return true;
+	}
+
+	std::vector<float> pointData;
+	std::vector<uint32_t> indexData;
+	// Bounds are reduced while parsing, as the points go by anyway
+	MeshBounds bounds;
+	parseGeometry(file, pointData, indexData, dimensions, &bounds);
+	file = ResourceData();
+
+	const int stride = dimensions + 3;
+	size_t vertexCount = pointData.size() / stride;
+	if (processing & GeometryProcessing_Optimize) {
+		MeshOptimizer::CacheStats before = MeshOptimizer::analyzeVertexCache(indexData, vertexCount);
+		if (MeshOptimizer::optimize(pointData, indexData, dimensions, stride)) {
+			MeshOptimizer::CacheStats after = MeshOptimizer::analyzeVertexCache(indexData, vertexCount);
+			std::cout
+				<< "Optimized " << path.filename() << ": "
+				<< "ACMR " << before.acmr << " -> " << after.acmr << ", "
+				<< "ATVR " << before.atvr << " -> " << after.atvr
+				<< std::endl;
 		}
-		else if (line == "[indices]") {
-			currentSection = Section::Indices;
+		else {
+			std::cerr << "Could not optimize " << path << ": index out of range" << std::endl;
 		}
-		else if (line[0] == '#' || line.empty()) {
-			// Do nothing, this is a comment
+	}
+
+	// Levels of detail are appended to the index buffer and share the
+	// vertices of the base mesh
+	std::vector<MeshLod> lods;
+	if (processing & GeometryProcessing_Lods) {
+		lods = MeshSimplifier::buildLods(pointData, indexData, dimensions, stride);
+		std::cout << "Built " << lods.size() << " levels of detail for " << path.filename() << ":";
+		for (const MeshLod& lod : lods) {
+			std::cout << " " << lod.indexCount / 3 << " (error " << lod.error << ")";
 		}
-		else if (currentSection == Section::Points) {
-			std::istringstream iss(line);
-			// Get x, y, r, g, b
-			for (int i = 0; i < dimensions + 3; ++i) {
-				iss >> value;
-				pointData.push_back(value);
-			}
+		std::cout << std::endl;
+	}
+
+	// Meshlet bounds are computed on the float positions, before quantization.
+	// Each level of detail gets its own meshlets.
+	std::vector<Meshlet> meshlets;
+	if (processing & GeometryProcessing_Meshlets) {
+		if (lods.empty()) {
+			meshlets = MeshletBuilder::build(pointData, indexData, dimensions, stride);
 		}
-		else if (currentSection == Section::Indices) {
-			std::istringstream iss(line);
-			// Get corners #0 #1 and #2
-			for (int i = 0; i < 3; ++i) {
-				iss >> index;
-				indexData.push_back(index);
-			}
+		for (MeshLod& lod : lods) {
+			std::vector<uint32_t> lodIndexData(
+				indexData.begin() + lod.indexOffset,
+				indexData.begin() + lod.indexOffset + lod.indexCount
+			);
+			std::vector<Meshlet> lodMeshlets = MeshletBuilder::build(pointData, lodIndexData, dimensions, stride);
+			for (Meshlet& meshlet : lodMeshlets) meshlet.indexOffset += lod.indexOffset;
+			lod.meshletOffset = static_cast<uint32_t>(meshlets.size());
+			lod.meshletCount = static_cast<uint32_t>(lodMeshlets.size());
+			meshlets.insert(meshlets.end(), lodMeshlets.begin(), lodMeshlets.end());
 		}
+		std::cout << "Built " << meshlets.size() << " meshlets for " << path.filename() << std::endl;
+	}
+
+	geometry.clear();
+	VertexLayout vertexLayout;
+	std::vector<uint8_t> vertexData = VertexQuantizer::quantize(pointData, dimensions, processing, vertexLayout, &bounds);
+	if (!vertexData.empty()) {
+		geometry.setVertices(std::move(vertexData), vertexLayout);
+	}
+	else {
+		geometry.setVertices(std::move(pointData), floatLayout);
+	}
+
+	if (Geometry::indexFormatFor(vertexCount) == WGPUIndexFormat_Uint16) {
+		geometry.setIndices(std::vector<uint16_t>(indexData.begin(), indexData.end()));
+	}
+	else {
+		geometry.setIndices(std::move(indexData));
+	}
+	geometry.setMeshlets(std::move(meshlets));
+	geometry.setLods(std::move(lods));
+	geometry.setBounds(bounds);
+
+	// Failing to write the cache (e.g. read-only resource directory) only
+	// means that the next launch parses the text file again.
+	if (!MeshCache::write(cacheKey, geometry)) {
+		std::cerr << "Could not write mesh cache for " << path << std::endl;
 	}
 	return true;
 }
 
-WGPUShaderModule ResourceManager::loadShaderModule(const std::filesystem::path& path, WGPUDevice device)
+bool ResourceManager::openGeometry(const std::filesystem::path& path, GeometrySource& source, int dimensions, GeometryProcessing processing)
 {
-	std::ifstream file(path);
-	if (!file.is_open()) {
+	source.streamer.reset();
+	if (processing != GeometryProcessing_None) {
+		return loadGeometry(path, source.geometry, dimensions, processing);
+	}
+
+	ResourceData file;
+	if (!loadResource(path, file)) {
+		std::cerr << "Could not load geometry!" << std::endl;
+		return false;
+	}
+	if (file.isPacked()) {
+		return loadGeometry(path, source.geometry, dimensions, processing);
+	}
+
+	source.cacheKey = MeshCache::makeKey(file.data(), file.size(), dimensions, processing);
+	if (MeshCache::read(source.cacheKey, source.geometry)) {
+		return true;
+	}
+
+	source.streamer = std::make_unique<GeometryStreamer>();
+	if (!source.streamer->open(path, dimensions)) {
 		std::cerr << "Could not load geometry!" << std::endl;
-		return nullptr;
+		source.streamer.reset();
+		return false;
 	}
-	file.seekg(0, std::ios::end);
-	size_t size = file.tellg();
-	std::string shaderSource(size, ' ');
-	file.seekg(0);
-	file.read(shaderSource.data(), size);
+	return true;
+}
 
+WGPUShaderModule ResourceManager::createShaderModule(const std::string& shaderSource, const std::string& label, WGPUDevice device)
+{
 	WGPUShaderSourceWGSL wgslDesc = WGPU_SHADER_SOURCE_WGSL_INIT;
 	wgslDesc.code = toWgpuStringView(shaderSource);
 	WGPUShaderModuleDescriptor shaderDesc = WGPU_SHADER_MODULE_DESCRIPTOR_INIT;
 	shaderDesc.nextInChain = &wgslDesc.chain;
-	shaderDesc.label = toWgpuStringView(path.string());
+	shaderDesc.label = toWgpuStringView(label);
 	return wgpuDeviceCreateShaderModule(device, &shaderDesc);
 }
@@ -1,23 +1,127 @@
 #pragma once
+#include <memory>
+#include <string>
+#include <string_view>
 #include <vector>
 #include <filesystem>
 #include <webgpu/webgpu.hpp>
+#include "Geometry.h"
+#include "GeometryStreamer.h"
+#include "MappedFile.h"
+#include "MeshCache.h"
+#include "ResourcePack.h"
+
+/**
+ * Bytes of a resource, viewed in place in a mounted pack or in the mapped
+ * file when possible. Keeps alive whatever it views.
+ */
+class ResourceData
+{
+public:
+	ByteView view() const { return m_view; }
+	const uint8_t* data() const { return m_view.data; }
+	size_t size() const { return m_view.size; }
+	std::string_view text() const { return std::string_view(reinterpret_cast<const char*>(m_view.data), m_view.size); }
+	// Whether the bytes come from a mounted pack rather than a file on disk
+	bool isPacked() const { return m_pack != nullptr; }
+
+private:
+	friend class ResourceManager;
+	std::shared_ptr<const ResourcePack> m_pack;
+	MappedFile m_file;
+	std::vector<uint8_t> m_copy;
+	ByteView m_view;
+};
+
+/**
+ * Geometry opened by ResourceManager::openGeometry(): either loaded as a
+ * whole, or ready to be streamed from its text file.
+ */
+struct GeometrySource
+{
+	// Holds the geometry when there is no streamer
+	Geometry geometry;
+	std::unique_ptr<GeometryStreamer> streamer;
+	// Entry to write while streaming, for the next launch
+	MeshCache::Key cacheKey;
+};
+
 class ResourceManager 
 {
 public:
+	/**
+	 * Serve the files below `mountPoint` from the pack at `packPath` rather
+	 * than from disk (see ResourcePack). Files that are not in the pack are
+	 * still read from disk. Packs are meant to be mounted before loading
+	 * starts, but lookups from loading threads are safe.
+	 */
+	static bool mountPack(const std::filesystem::path& packPath, const std::filesystem::path& mountPoint);
+	static void unmountPacks();
+
+	/**
+	 * Bytes of the file at `path`, from a mounted pack if it has it or from
+	 * disk otherwise. Neither copies unless the pack entry is compressed.
+	 */
+	static bool loadResource(const std::filesystem::path& path, ResourceData& data);
+
 	/**
 	 * Load a file from `path` using our ad-hoc format and populate the `pointData`
-	 * and `indexData` vectors.
+	 * and `indexData` vectors, and `bounds` if given.
 	 */
 	static bool loadGeometry(
 		const std::filesystem::path& path,
 		std::vector<float>& pointData,
 		std::vector<uint16_t>& indexData,
-		int dimensions
+		int dimensions,
+		MeshBounds* bounds = nullptr
+	);
+	static bool loadGeometry(
+		const std::filesystem::path& path,
+		std::vector<float>& pointData,
+		std::vector<uint32_t>& indexData,
+		int dimensions,
+		MeshBounds* bounds = nullptr
 	);
 
-	static WGPUShaderModule loadShaderModule(
+	/**
+	 * Same as above, but go through the binary mesh cache (see MeshCache): if
+	 * the content of `path` was already processed with the same options, here
+	 * or on any machine sharing the asset cache, the result is memory-mapped
+	 * and no parsing happens. Otherwise the text file is parsed and the cache
+	 * entry is written.
+	 * Indices are stored as 16-bit whenever the vertex count allows it.
+	 * `processing` selects optional post-load steps, the cache stores their
+	 * result so they only run when the cache is rebuilt.
+	 */
+	static bool loadGeometry(
 		const std::filesystem::path& path,
+		Geometry& geometry,
+		int dimensions,
+		GeometryProcessing processing = GeometryProcessing_None
+	);
+
+	/**
+	 * Same as loadGeometry(), except that unprocessed geometry that is not in
+	 * the binary mesh cache is not parsed: `source` gets a streamer over the
+	 * text file instead (see GeometryStreamer), so that the mesh is never
+	 * held in memory as a whole. Processed geometry needs the whole mesh,
+	 * and packed geometry cannot be mapped by the streamer, so both are
+	 * loaded.
+	 */
+	static bool openGeometry(
+		const std::filesystem::path& path,
+		GeometrySource& source,
+		int dimensions,
+		GeometryProcessing processing = GeometryProcessing_None
+	);
+
+	/**
+	 * Compile a WGSL source. Modules are shared by content through the
+	 * ShaderModuleCache, which is where this should be called from.
+	 */
+	static WGPUShaderModule createShaderModule(
+		const std::string& shaderSource,
+		const std::string& label,
 		WGPUDevice device
 	);
 
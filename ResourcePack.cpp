@@ -0,0 +1,207 @@
+#include "ResourcePack.h"
+#include "Hash.h"
+#include "Lz4.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <system_error>
+#include <tuple>
+
+namespace
+{
+	uint64_t alignUp(uint64_t value, uint64_t alignment)
+	{
+		return (value + alignment - 1) / alignment * alignment;
+	}
+
+	uint64_t hashName(std::string_view name)
+	{
+		return Hasher::hash(name.data(), name.size());
+	}
+
+	// Whether `offset + size` fits in `limit`, without overflowing
+	bool fits(uint64_t offset, uint64_t size, uint64_t limit)
+	{
+		return size <= limit && offset <= limit - size;
+	}
+}
+
+bool ResourcePack::open(const std::filesystem::path& path)
+{
+	close();
+	if (!m_file.open(path)) return false;
+
+	const uint64_t fileSize = m_file.size();
+	bool valid = fileSize >= sizeof(Header);
+	const Header* header = reinterpret_cast<const Header*>(m_file.data());
+	valid = valid && header->magic == Magic && header->version == Version;
+	valid = valid && header->entryOffset % alignof(Entry) == 0;
+	valid = valid && header->entryCount <= fileSize / sizeof(Entry);
+	valid = valid && fits(header->entryOffset, header->entryCount * sizeof(Entry), fileSize);
+	valid = valid && fits(header->nameOffset, header->nameSize, fileSize);
+	if (!valid) {
+		std::cerr << "Invalid resource pack " << path << std::endl;
+		close();
+		return false;
+	}
+
+	m_entries = reinterpret_cast<const Entry*>(m_file.data() + header->entryOffset);
+	m_entryCount = static_cast<size_t>(header->entryCount);
+	m_names = reinterpret_cast<const char*>(m_file.data() + header->nameOffset);
+
+	for (size_t i = 0; i < m_entryCount && valid; ++i) {
+		const Entry& entry = m_entries[i];
+		valid = fits(entry.nameOffset, entry.nameSize, header->nameSize);
+		valid = valid && fits(entry.offset, entry.storedSize, fileSize);
+		valid = valid && (
+			(entry.compression == Compression_None && entry.storedSize == entry.size) ||
+			entry.compression == Compression_Lz4
+		);
+		// find() relies on the order of the table
+		valid = valid && (i == 0 || std::make_tuple(m_entries[i - 1].nameHash, entryName(m_entries[i - 1])) < std::make_tuple(entry.nameHash, entryName(entry)));
+	}
+	if (!valid) {
+		std::cerr << "Corrupted resource pack " << path << std::endl;
+		close();
+		return false;
+	}
+	return true;
+}
+
+void ResourcePack::close()
+{
+	m_file.close();
+	m_entries = nullptr;
+	m_entryCount = 0;
+	m_names = nullptr;
+}
+
+std::string_view ResourcePack::entryName(const Entry& entry) const
+{
+	return std::string_view(m_names + entry.nameOffset, entry.nameSize);
+}
+
+const ResourcePack::Entry* ResourcePack::find(std::string_view name) const
+{
+	const uint64_t nameHash = hashName(name);
+	const Entry* end = m_entries + m_entryCount;
+	const Entry* it = std::lower_bound(m_entries, end, nameHash, [](const Entry& entry, uint64_t hash) {
+		return entry.nameHash < hash;
+	});
+	for (; it != end && it->nameHash == nameHash; ++it) {
+		if (entryName(*it) == name) return it;
+	}
+	return nullptr;
+}
+
+bool ResourcePack::view(const Entry& entry, ByteView& bytes) const
+{
+	if (entry.compression != Compression_None) return false;
+	bytes.data = m_file.data() + entry.offset;
+	bytes.size = static_cast<size_t>(entry.size);
+	return true;
+}
+
+bool ResourcePack::read(const Entry& entry, std::vector<uint8_t>& bytes) const
+{
+	const uint8_t* stored = m_file.data() + entry.offset;
+	if (entry.compression == Compression_None) {
+		bytes.assign(stored, stored + entry.size);
+		return true;
+	}
+	bytes.resize(static_cast<size_t>(entry.size));
+	return Lz4::decompress(stored, static_cast<size_t>(entry.storedSize), bytes.data(), bytes.size());
+}
+
+bool ResourcePack::write(const std::filesystem::path& path, const std::vector<Source>& sources, bool compress)
+{
+	// Sort sources the way find() looks them up
+	std::vector<Entry> entries(sources.size());
+	std::vector<size_t> order(sources.size());
+	for (size_t i = 0; i < sources.size(); ++i) {
+		entries[i] = {};
+		entries[i].nameHash = hashName(sources[i].name);
+		entries[i].nameSize = static_cast<uint32_t>(sources[i].name.size());
+		order[i] = i;
+	}
+	std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+		return std::tie(entries[a].nameHash, sources[a].name) < std::tie(entries[b].nameHash, sources[b].name);
+	});
+	for (size_t i = 1; i < order.size(); ++i) {
+		if (sources[order[i - 1]].name == sources[order[i]].name) {
+			std::cerr << "Duplicate resource " << sources[order[i]].name << std::endl;
+			return false;
+		}
+	}
+
+	Header header = {};
+	header.magic = Magic;
+	header.version = Version;
+	header.entryCount = sources.size();
+	header.entryOffset = alignUp(sizeof(Header), BlobAlignment);
+	header.nameOffset = header.entryOffset + sources.size() * sizeof(Entry);
+	std::string names;
+	for (size_t index : order) {
+		entries[index].nameOffset = names.size();
+		names += sources[index].name;
+	}
+	header.nameSize = names.size();
+
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	if (!file.is_open()) {
+		std::cerr << "Could not write resource pack " << path << std::endl;
+		return false;
+	}
+
+	uint64_t offset = header.nameOffset + header.nameSize;
+	bool success = true;
+	for (size_t index : order) {
+		MappedFile source;
+		if (!source.open(sources[index].path)) {
+			std::cerr << "Could not read " << sources[index].path << std::endl;
+			success = false;
+			break;
+		}
+
+		Entry& entry = entries[index];
+		entry.size = source.size();
+		entry.storedSize = source.size();
+		entry.compression = Compression_None;
+		const uint8_t* blob = source.data();
+		std::vector<uint8_t> compressed;
+		// The compressor addresses its input with 32-bit positions
+		if (compress && source.size() > 0 && source.size() <= std::numeric_limits<uint32_t>::max()) {
+			compressed = Lz4::compress(source.data(), source.size());
+			if (compressed.size() <= source.size() - source.size() / 8) {
+				entry.storedSize = compressed.size();
+				entry.compression = Compression_Lz4;
+				blob = compressed.data();
+			}
+		}
+
+		entry.offset = alignUp(offset, BlobAlignment);
+		offset = entry.offset + entry.storedSize;
+		file.seekp(static_cast<std::streamoff>(entry.offset));
+		file.write(reinterpret_cast<const char*>(blob), static_cast<std::streamsize>(entry.storedSize));
+	}
+
+	if (success) {
+		std::vector<Entry> sortedEntries;
+		sortedEntries.reserve(entries.size());
+		for (size_t index : order) sortedEntries.push_back(entries[index]);
+		file.seekp(0);
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.seekp(static_cast<std::streamoff>(header.entryOffset));
+		file.write(reinterpret_cast<const char*>(sortedEntries.data()), static_cast<std::streamsize>(sortedEntries.size() * sizeof(Entry)));
+		file.write(names.data(), static_cast<std::streamsize>(names.size()));
+		success = file.good();
+	}
+	file.close();
+	if (!success) {
+		std::error_code ec;
+		std::filesystem::remove(path, ec);
+	}
+	return success;
+}
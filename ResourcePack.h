@@ -0,0 +1,122 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+#include "MappedFile.h"
+
+/**
+ * Non-owning view of contiguous bytes, like std::span<const uint8_t>.
+ */
+struct ByteView
+{
+	const uint8_t* data = nullptr;
+	size_t size = 0;
+
+	const uint8_t* begin() const { return data; }
+	const uint8_t* end() const { return data + size; }
+	bool empty() const { return size == 0; }
+};
+
+/**
+ * Read-only archive of resources, memory-mapped as a whole so that entries
+ * are served without any per-file open, seek or read.
+ *
+ * Layout (native endianness, like MeshCache):
+ *   Header
+ *   entry table (Entry[entryCount], sorted by name hash then name)
+ *   name table  (entry names, '/' separated paths relative to the packed
+ *                directory, not null-terminated)
+ *   blobs       (each starting on a 16-byte boundary)
+ *
+ * Entries are either stored as is, and viewed in place, or compressed with
+ * Lz4, in which case reading them decompresses a copy.
+ */
+class ResourcePack
+{
+public:
+	static constexpr uint32_t Magic = 0x4B504757; // "WGPK" in little endian
+	static constexpr uint32_t Version = 1;
+	static constexpr uint64_t BlobAlignment = 16;
+
+	enum Compression : uint32_t
+	{
+		Compression_None = 0,
+		Compression_Lz4 = 1,
+	};
+
+	struct Header
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint64_t entryCount;
+		uint64_t entryOffset;
+		uint64_t nameOffset;
+		uint64_t nameSize;
+	};
+	static_assert(std::is_trivially_copyable<Header>::value, "the header is read straight from the mapped file");
+
+	struct Entry
+	{
+		uint64_t nameHash;
+		uint64_t nameOffset; // in the name table
+		uint64_t offset; // of the blob, from the start of the file
+		uint64_t size; // once decompressed
+		uint64_t storedSize; // in the pack
+		uint32_t nameSize;
+		uint32_t compression; // Compression
+	};
+	static_assert(sizeof(Entry) == 48, "the entry table is read straight from the mapped file");
+
+	/**
+	 * Map the pack at `path` and check that its whole table of contents is
+	 * consistent, so that no later access can read out of bounds.
+	 */
+	bool open(const std::filesystem::path& path);
+	void close();
+	bool isOpen() const { return m_file.isOpen(); }
+
+	size_t entryCount() const { return m_entryCount; }
+	const Entry& entry(size_t index) const { return m_entries[index]; }
+	std::string_view entryName(const Entry& entry) const;
+
+	/**
+	 * Entry named `name` (e.g. "shader.wgsl"), or null if there is none.
+	 */
+	const Entry* find(std::string_view name) const;
+
+	/**
+	 * View of an entry inside the mapping, valid as long as the pack is
+	 * open. Fail for compressed entries, which must be read().
+	 */
+	bool view(const Entry& entry, ByteView& bytes) const;
+
+	/**
+	 * Copy of an entry, decompressed if needed.
+	 */
+	bool read(const Entry& entry, std::vector<uint8_t>& bytes) const;
+
+	/**
+	 * A file to pack, and the name it is stored under.
+	 */
+	struct Source
+	{
+		std::string name;
+		std::filesystem::path path;
+	};
+
+	/**
+	 * Write a pack of `sources`. With `compress`, entries are compressed when
+	 * it saves at least an eighth of their size.
+	 */
+	static bool write(const std::filesystem::path& path, const std::vector<Source>& sources, bool compress);
+
+private:
+	MappedFile m_file;
+	const Entry* m_entries = nullptr;
+	size_t m_entryCount = 0;
+	const char* m_names = nullptr;
+};
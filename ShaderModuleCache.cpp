@@ -0,0 +1,157 @@
+#include "ShaderModuleCache.h"
+#include "Hash.h"
+#include "ResourceManager.h"
+
+#include <algorithm>
+#include <iostream>
+#include <iterator>
+
+ShaderModuleCache::ShaderModuleCache(WGPUDevice device)
+	: m_device(device)
+{}
+
+ShaderModuleCache::~ShaderModuleCache()
+{
+	for (auto& [key, entry] : m_entries) {
+		wgpuShaderModuleRelease(entry.module);
+	}
+}
+
+uint64_t ShaderModuleCache::makeKey(const std::string& source, const std::vector<std::string>& entryPoints)
+{
+	Hasher hasher;
+	hasher.updateString(source);
+	hasher.updateValue(static_cast<uint64_t>(entryPoints.size()));
+	for (const std::string& entryPoint : entryPoints) {
+		hasher.updateString(entryPoint);
+	}
+	return hasher.digest();
+}
+
+ShaderModuleCache::VariantKey ShaderModuleCache::makeVariantKey(const std::filesystem::path& path, ShaderFeatures features)
+{
+	return { path.lexically_normal().generic_string(), features };
+}
+
+WGPUShaderModule ShaderModuleCache::acquire(const std::string& source, const std::string& label, const std::vector<std::string>& entryPoints)
+{
+	const uint64_t key = makeKey(source, entryPoints);
+	auto range = m_entries.equal_range(key);
+	for (auto it = range.first; it != range.second; ++it) {
+		Entry& entry = it->second;
+		if (entry.source == source && entry.entryPoints == entryPoints) {
+			++entry.refCount;
+			++m_hitCount;
+			return entry.module;
+		}
+	}
+
+	++m_missCount;
+	WGPUShaderModule module = ResourceManager::createShaderModule(source, label, m_device);
+	if (module == nullptr) return nullptr;
+
+	Entry entry;
+	entry.source = source;
+	entry.entryPoints = entryPoints;
+	entry.module = module;
+	entry.refCount = 1;
+	entry.reflected = ShaderReflector::reflect(source, entry.reflection);
+	if (!entry.reflected) {
+		std::cerr << "Could not reflect shader " << label << "!" << std::endl;
+	}
+	m_entries.emplace(key, std::move(entry));
+	m_keys[module] = key;
+	return module;
+}
+
+WGPUShaderModule ShaderModuleCache::acquireVariant(const std::filesystem::path& path, ShaderFeatures features)
+{
+	auto it = m_variants.find(makeVariantKey(path, features));
+	if (it != m_variants.end()) {
+		addRef(it->second.module);
+		++m_hitCount;
+		return it->second.module;
+	}
+
+	PreprocessedShader shader;
+	if (!ShaderPreprocessor::preprocess(path, ShaderPreprocessor::definesFor(features), shader)) {
+		return nullptr;
+	}
+	return acquireVariant(path, features, shader);
+}
+
+WGPUShaderModule ShaderModuleCache::acquireVariant(const std::filesystem::path& path, ShaderFeatures features, const PreprocessedShader& shader)
+{
+	// Variants that preprocess to the same source share their module
+	WGPUShaderModule module = acquire(shader.source, path.string());
+	if (module != nullptr) {
+		m_variants[makeVariantKey(path, features)] = { module, shader.dependencies };
+	}
+	return module;
+}
+
+void ShaderModuleCache::invalidate(const std::filesystem::path& changedPath)
+{
+	const std::filesystem::path normalPath = changedPath.lexically_normal();
+	for (auto it = m_variants.begin(); it != m_variants.end();) {
+		const std::vector<std::filesystem::path>& dependencies = it->second.dependencies;
+		if (std::find(dependencies.begin(), dependencies.end(), normalPath) != dependencies.end()) {
+			it = m_variants.erase(it);
+		}
+		else {
+			++it;
+		}
+	}
+}
+
+const ShaderModuleCache::Entry* ShaderModuleCache::findEntry(WGPUShaderModule module) const
+{
+	auto keyIt = m_keys.find(module);
+	if (keyIt == m_keys.end()) return nullptr;
+	auto range = m_entries.equal_range(keyIt->second);
+	for (auto it = range.first; it != range.second; ++it) {
+		if (it->second.module == module) return &it->second;
+	}
+	return nullptr;
+}
+
+void ShaderModuleCache::addRef(WGPUShaderModule module)
+{
+	auto keyIt = m_keys.find(module);
+	if (keyIt == m_keys.end()) return;
+	auto range = m_entries.equal_range(keyIt->second);
+	for (auto it = range.first; it != range.second; ++it) {
+		if (it->second.module == module) {
+			++it->second.refCount;
+			return;
+		}
+	}
+}
+
+const ShaderReflection* ShaderModuleCache::reflection(WGPUShaderModule module) const
+{
+	const Entry* entry = findEntry(module);
+	return entry != nullptr && entry->reflected ? &entry->reflection : nullptr;
+}
+
+void ShaderModuleCache::release(WGPUShaderModule module)
+{
+	auto keyIt = m_keys.find(module);
+	if (keyIt == m_keys.end()) {
+		std::cerr << "Releasing shader module " << module << " that is not in the cache" << std::endl;
+		return;
+	}
+	auto range = m_entries.equal_range(keyIt->second);
+	for (auto it = range.first; it != range.second; ++it) {
+		if (it->second.module != module) continue;
+		if (--it->second.refCount == 0) {
+			wgpuShaderModuleRelease(module);
+			m_entries.erase(it);
+			m_keys.erase(keyIt);
+			for (auto variant = m_variants.begin(); variant != m_variants.end();) {
+				variant = variant->second.module == module ? m_variants.erase(variant) : std::next(variant);
+			}
+		}
+		return;
+	}
+}
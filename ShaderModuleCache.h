@@ -0,0 +1,125 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <webgpu/webgpu.h>
+#include "ShaderPreprocessor.h"
+#include "ShaderReflection.h"
+
+/**
+ * Shader modules of a device, deduplicated by content: asking twice for the
+ * same WGSL source (and entry points) returns the same WGPUShaderModule
+ * instead of parsing and compiling the WGSL again, which is the largest
+ * single cost of creating a pipeline.
+ *
+ * Shader files are compiled per variant, i.e. per set of ShaderFeatures
+ * (see ShaderPreprocessor). Variants are remembered, so asking for one
+ * again neither reads nor preprocesses its files.
+ *
+ * Each module is reflected once when it is compiled (see ShaderReflector),
+ * so that pipeline layouts can be generated from it.
+ *
+ * Modules are reference counted: each acquire() must be balanced by a
+ * release(), and the module is released once nobody uses it any more.
+ * Like the device itself, the cache is only used from the render thread.
+ */
+class ShaderModuleCache
+{
+public:
+	explicit ShaderModuleCache(WGPUDevice device);
+	// Release every module, whether or not they were all released
+	~ShaderModuleCache();
+
+	ShaderModuleCache(const ShaderModuleCache&) = delete;
+	ShaderModuleCache& operator=(const ShaderModuleCache&) = delete;
+
+	/**
+	 * Module compiled from `source`, created on first use. `entryPoints`
+	 * lists the entry points the caller relies on and is part of the key, so
+	 * that modules meant for different stages stay apart. `label` only names
+	 * the module when it is created. Return null if the device could not
+	 * create the module, in which case nothing needs releasing.
+	 */
+	WGPUShaderModule acquire(
+		const std::string& source,
+		const std::string& label,
+		const std::vector<std::string>& entryPoints = {}
+	);
+
+	/**
+	 * Module of the variant of the shader file at `path` with `features`,
+	 * preprocessed on first use only.
+	 */
+	WGPUShaderModule acquireVariant(const std::filesystem::path& path, ShaderFeatures features);
+
+	/**
+	 * Same as above with a variant preprocessed elsewhere, typically on a
+	 * loading thread, which is remembered as the variant from now on.
+	 */
+	WGPUShaderModule acquireVariant(const std::filesystem::path& path, ShaderFeatures features, const PreprocessedShader& shader);
+
+	/**
+	 * Forget the variants built from `changedPath`, so that they are
+	 * preprocessed again on next use. Modules in use stay valid.
+	 */
+	void invalidate(const std::filesystem::path& changedPath);
+
+	/**
+	 * Take one more reference to a module returned by acquire().
+	 */
+	void addRef(WGPUShaderModule module);
+
+	/**
+	 * Drop a reference, and the module itself with the last one.
+	 */
+	void release(WGPUShaderModule module);
+
+	/**
+	 * Declarations of a module returned by acquire(), or null if its source
+	 * could not be reflected, which has already been reported.
+	 */
+	const ShaderReflection* reflection(WGPUShaderModule module) const;
+
+	// Number of distinct modules alive
+	size_t size() const { return m_entries.size(); }
+	// Number of acquire() calls served without compiling
+	uint64_t hitCount() const { return m_hitCount; }
+	uint64_t missCount() const { return m_missCount; }
+
+private:
+	struct Entry
+	{
+		// Compared on lookup, so that a hash collision can never hand out
+		// the wrong module
+		std::string source;
+		std::vector<std::string> entryPoints;
+		WGPUShaderModule module = nullptr;
+		uint32_t refCount = 0;
+		bool reflected = false;
+		ShaderReflection reflection;
+	};
+
+	// Does not hold a reference, it goes away with its module
+	struct Variant
+	{
+		WGPUShaderModule module = nullptr;
+		std::vector<std::filesystem::path> dependencies;
+	};
+	using VariantKey = std::pair<std::string, ShaderFeatures>;
+
+	static uint64_t makeKey(const std::string& source, const std::vector<std::string>& entryPoints);
+	static VariantKey makeVariantKey(const std::filesystem::path& path, ShaderFeatures features);
+	const Entry* findEntry(WGPUShaderModule module) const;
+
+	WGPUDevice m_device;
+	std::unordered_multimap<uint64_t, Entry> m_entries;
+	std::unordered_map<WGPUShaderModule, uint64_t> m_keys;
+	std::map<VariantKey, Variant> m_variants;
+	uint64_t m_hitCount = 0;
+	uint64_t m_missCount = 0;
+};
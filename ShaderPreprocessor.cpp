@@ -0,0 +1,211 @@
+#include "ShaderPreprocessor.h"
+#include "ResourceManager.h"
+
+#include <algorithm>
+#include <iostream>
+#include <string_view>
+#include <unordered_map>
+
+namespace
+{
+	struct Context
+	{
+		std::unordered_map<std::string, std::string> defines;
+		// Number of defines that have a value to substitute
+		size_t valueCount = 0;
+		PreprocessedShader& shader;
+	};
+
+	// State of an #ifdef / #ifndef block
+	struct Condition
+	{
+		bool active;
+		bool parentActive;
+		bool seenElse;
+	};
+
+	bool isBlank(char c)
+	{
+		return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+	}
+
+	bool isIdentifierStart(char c)
+	{
+		return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+	}
+
+	bool isIdentifierChar(char c)
+	{
+		return isIdentifierStart(c) || (c >= '0' && c <= '9');
+	}
+
+	std::string_view trim(std::string_view text)
+	{
+		while (!text.empty() && isBlank(text.front())) text.remove_prefix(1);
+		while (!text.empty() && isBlank(text.back())) text.remove_suffix(1);
+		return text;
+	}
+
+	/**
+	 * Split the leading identifier off `text`, which is left with the rest.
+	 */
+	std::string_view takeIdentifier(std::string_view& text)
+	{
+		text = trim(text);
+		size_t length = 0;
+		if (!text.empty() && isIdentifierStart(text[0])) {
+			while (length < text.size() && isIdentifierChar(text[length])) ++length;
+		}
+		std::string_view identifier = text.substr(0, length);
+		text = trim(text.substr(length));
+		return identifier;
+	}
+
+	void setDefine(Context& context, const std::string& name, const std::string& value)
+	{
+		auto it = context.defines.find(name);
+		if (it != context.defines.end() && !it->second.empty()) --context.valueCount;
+		context.defines[name] = value;
+		if (!value.empty()) ++context.valueCount;
+	}
+
+	void undefine(Context& context, const std::string& name)
+	{
+		auto it = context.defines.find(name);
+		if (it == context.defines.end()) return;
+		if (!it->second.empty()) --context.valueCount;
+		context.defines.erase(it);
+	}
+
+	/**
+	 * Append a line of code, with defined names replaced by their values.
+	 */
+	void appendExpanded(const Context& context, std::string_view line, std::string& output)
+	{
+		if (context.valueCount == 0) {
+			output += line;
+			return;
+		}
+		size_t i = 0;
+		while (i < line.size()) {
+			if (!isIdentifierStart(line[i]) || (i > 0 && isIdentifierChar(line[i - 1]))) {
+				output += line[i++];
+				continue;
+			}
+			size_t end = i;
+			while (end < line.size() && isIdentifierChar(line[end])) ++end;
+			std::string identifier(line.substr(i, end - i));
+			auto it = context.defines.find(identifier);
+			output += it != context.defines.end() && !it->second.empty() ? it->second : identifier;
+			i = end;
+		}
+	}
+
+	bool processFile(Context& context, const std::filesystem::path& path)
+	{
+		ResourceData file;
+		if (!ResourceManager::loadResource(path, file)) {
+			std::cerr << "Could not load shader " << path << "!" << std::endl;
+			return false;
+		}
+		context.shader.dependencies.push_back(path);
+
+		std::vector<Condition> conditions;
+		auto isActive = [&]() { return conditions.empty() || conditions.back().active; };
+		size_t lineNumber = 0;
+		auto fail = [&](const std::string& message) {
+			std::cerr << path.string() << ":" << lineNumber << ": " << message << std::endl;
+			return false;
+		};
+
+		std::string_view text = file.text();
+		std::string& output = context.shader.source;
+		while (!text.empty()) {
+			++lineNumber;
+			size_t newline = text.find('\n');
+			std::string_view line = text.substr(0, newline);
+			text = newline == std::string_view::npos ? std::string_view() : text.substr(newline + 1);
+			if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+
+			std::string_view directive = trim(line);
+			if (directive.empty() || directive[0] != '#') {
+				if (isActive()) appendExpanded(context, line, output);
+				output += '\n';
+				continue;
+			}
+
+			directive.remove_prefix(1);
+			std::string_view arguments = directive;
+			std::string_view name = takeIdentifier(arguments);
+			if (name == "ifdef" || name == "ifndef") {
+				std::string_view macro = takeIdentifier(arguments);
+				if (macro.empty()) return fail("expected a name after #" + std::string(name));
+				bool defined = context.defines.count(std::string(macro)) > 0;
+				bool parentActive = isActive();
+				conditions.push_back({ parentActive && defined == (name == "ifdef"), parentActive, false });
+			}
+			else if (name == "else") {
+				if (conditions.empty() || conditions.back().seenElse) return fail("unexpected #else");
+				Condition& condition = conditions.back();
+				condition.active = condition.parentActive && !condition.active;
+				condition.seenElse = true;
+			}
+			else if (name == "endif") {
+				if (conditions.empty()) return fail("unexpected #endif");
+				conditions.pop_back();
+			}
+			else if (!isActive()) {
+				// Other directives are ignored in skipped blocks
+			}
+			else if (name == "define") {
+				std::string_view macro = takeIdentifier(arguments);
+				if (macro.empty()) return fail("expected a name after #define");
+				setDefine(context, std::string(macro), std::string(arguments));
+			}
+			else if (name == "undef") {
+				std::string_view macro = takeIdentifier(arguments);
+				if (macro.empty()) return fail("expected a name after #undef");
+				undefine(context, std::string(macro));
+			}
+			else if (name == "include") {
+				if (arguments.size() < 2 || arguments.front() != '"' || arguments.back() != '"') {
+					return fail("expected #include \"file\"");
+				}
+				std::filesystem::path included = (path.parent_path() / std::string(arguments.substr(1, arguments.size() - 2))).lexically_normal();
+				const std::vector<std::filesystem::path>& dependencies = context.shader.dependencies;
+				if (std::find(dependencies.begin(), dependencies.end(), included) == dependencies.end()) {
+					if (!processFile(context, included)) return fail("included from here");
+				}
+				continue;
+			}
+			else {
+				return fail("unknown directive #" + std::string(name));
+			}
+			output += '\n';
+		}
+
+		if (!conditions.empty()) return fail("missing #endif");
+		return true;
+	}
+}
+
+std::vector<ShaderPreprocessor::Define> ShaderPreprocessor::definesFor(ShaderFeatures features)
+{
+	std::vector<Define> defines;
+	if (features & ShaderFeature_MeshletCulling) defines.push_back({ "MESHLET_CULLING", "" });
+	return defines;
+}
+
+bool ShaderPreprocessor::preprocess(
+	const std::filesystem::path& path,
+	const std::vector<Define>& defines,
+	PreprocessedShader& shader
+)
+{
+	shader = PreprocessedShader();
+	Context context{ {}, 0, shader };
+	for (const Define& define : defines) {
+		setDefine(context, define.name, define.value);
+	}
+	return processFile(context, path.lexically_normal());
+}
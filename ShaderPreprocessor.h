@@ -0,0 +1,67 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+/**
+ * Optional shader features, as a bit mask. Each one enables a preprocessor
+ * define, so that a variant only contains the code its draws need instead
+ * of branching at run time (see ShaderPreprocessor::definesFor()). Each
+ * variant is a separate module, so features that do not change what the
+ * shader declares are better left to overrides, which specialize pipelines
+ * of a single module (see PipelineConstant).
+ */
+typedef uint32_t ShaderFeatures;
+static const ShaderFeatures ShaderFeature_None = 0;
+// Meshlet culling compute pass, cs_cull (MESHLET_CULLING)
+static const ShaderFeatures ShaderFeature_MeshletCulling = 1 << 0;
+
+/**
+ * WGSL after preprocessing, with every file it was built from.
+ */
+struct PreprocessedShader
+{
+	std::string source;
+	// The main file first, then included files in the order they were met
+	std::vector<std::filesystem::path> dependencies;
+};
+
+/**
+ * A minimal C-like preprocessor in front of the WGSL compiler, which has
+ * none. Directives are lines whose first non-blank character is '#':
+ *  - `#include "file.wgsl"`, relative to the including file. A file is
+ *    included at most once, as WGSL forbids duplicate declarations anyway;
+ *  - `#define NAME [value]` and `#undef NAME`. Names defined with a value
+ *    are replaced by it in the code that follows;
+ *  - `#ifdef NAME`, `#ifndef NAME`, `#else` and `#endif`, which nest.
+ *
+ * Directives and skipped lines are replaced by empty lines, so that line
+ * numbers in compilation errors still match the main file up to its first
+ * include. Files are read through the ResourceManager, so this runs on any
+ * thread and sees mounted packs.
+ */
+class ShaderPreprocessor
+{
+public:
+	struct Define
+	{
+		std::string name;
+		std::string value;
+	};
+
+	/**
+	 * Defines enabled by a set of features.
+	 */
+	static std::vector<Define> definesFor(ShaderFeatures features);
+
+	/**
+	 * Preprocess the file at `path` with `defines` set beforehand. Report
+	 * errors with their file and line and return false.
+	 */
+	static bool preprocess(
+		const std::filesystem::path& path,
+		const std::vector<Define>& defines,
+		PreprocessedShader& shader
+	);
+};
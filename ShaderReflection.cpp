@@ -0,0 +1,777 @@
+#include "ShaderReflection.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <set>
+#include <string_view>
+
+namespace
+{
+	struct Token
+	{
+		enum Kind { Identifier, Number, Symbol, End };
+		Kind kind;
+		std::string_view text;
+		size_t line;
+	};
+
+	// A type as written, e.g. array<vec3f, 4>, where 4 is an argument
+	// without arguments of its own
+	struct TypeExpr
+	{
+		std::string name;
+		std::vector<TypeExpr> arguments;
+
+		std::string text() const
+		{
+			std::string result = name;
+			if (arguments.empty()) return result;
+			result += '<';
+			for (size_t i = 0; i < arguments.size(); ++i) {
+				if (i > 0) result += ", ";
+				result += arguments[i].text();
+			}
+			return result + '>';
+		}
+	};
+
+	struct Attribute
+	{
+		std::string name;
+		std::vector<std::string> arguments;
+	};
+
+	bool isIdentifierStart(char c)
+	{
+		return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+	}
+
+	bool isDigit(char c)
+	{
+		return c >= '0' && c <= '9';
+	}
+
+	bool isIdentifierChar(char c)
+	{
+		return isIdentifierStart(c) || isDigit(c);
+	}
+
+	uint32_t alignTo(uint32_t value, uint32_t alignment)
+	{
+		return (value + alignment - 1) / alignment * alignment;
+	}
+
+	// Literals may have a suffix (64u) and be hexadecimal
+	bool parseInteger(const std::string& text, uint32_t& value)
+	{
+		if (text.empty() || !isDigit(text[0])) return false;
+		value = static_cast<uint32_t>(std::strtoul(text.c_str(), nullptr, 0));
+		return true;
+	}
+
+	const Attribute* findAttribute(const std::vector<Attribute>& attributes, const std::string& name)
+	{
+		for (const Attribute& attribute : attributes) {
+			if (attribute.name == name) return &attribute;
+		}
+		return nullptr;
+	}
+
+	bool integerAttribute(const std::vector<Attribute>& attributes, const std::string& name, uint32_t& value)
+	{
+		const Attribute* attribute = findAttribute(attributes, name);
+		return attribute != nullptr && attribute->arguments.size() == 1 && parseInteger(attribute->arguments[0], value);
+	}
+
+	bool tokenize(std::string_view source, std::vector<Token>& tokens)
+	{
+		size_t line = 1;
+		size_t i = 0;
+		while (i < source.size()) {
+			const char c = source[i];
+			if (c == '\n') {
+				++line;
+				++i;
+				continue;
+			}
+			if (c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f') {
+				++i;
+				continue;
+			}
+			if (source.compare(i, 2, "//") == 0) {
+				while (i < source.size() && source[i] != '\n') ++i;
+				continue;
+			}
+			if (source.compare(i, 2, "/*") == 0) {
+				// Block comments nest in WGSL
+				const size_t startLine = line;
+				int depth = 0;
+				do {
+					if (source.compare(i, 2, "/*") == 0) {
+						++depth;
+						i += 2;
+					}
+					else if (source.compare(i, 2, "*/") == 0) {
+						--depth;
+						i += 2;
+					}
+					else {
+						if (source[i] == '\n') ++line;
+						++i;
+					}
+				} while (depth > 0 && i < source.size());
+				if (depth > 0) {
+					std::cerr << "WGSL line " << startLine << ": unterminated comment" << std::endl;
+					return false;
+				}
+				continue;
+			}
+
+			const size_t start = i;
+			Token::Kind kind = Token::Symbol;
+			if (isIdentifierStart(c)) {
+				while (i < source.size() && isIdentifierChar(source[i])) ++i;
+				kind = Token::Identifier;
+			}
+			else if (isDigit(c)) {
+				while (i < source.size() && (isIdentifierChar(source[i]) || source[i] == '.')) ++i;
+				kind = Token::Number;
+			}
+			else {
+				// Multi-character operators only appear in code that is skipped
+				++i;
+			}
+			tokens.push_back({ kind, source.substr(start, i - start), line });
+		}
+		tokens.push_back({ Token::End, {}, line });
+		return true;
+	}
+
+	class Parser
+	{
+	public:
+		Parser(const std::vector<Token>& tokens, ShaderReflection& reflection)
+			: m_tokens(tokens)
+			, m_reflection(reflection)
+		{}
+
+		bool parse()
+		{
+			while (peek().kind != Token::End) {
+				if (accept(";")) continue;
+				std::vector<Attribute> attributes;
+				if (!parseAttributes(attributes)) return false;
+				if (accept("struct")) {
+					if (!parseStruct()) return false;
+				}
+				else if (accept("var")) {
+					if (!parseVariable(attributes)) return false;
+				}
+				else if (accept("fn")) {
+					if (!parseFunction(attributes)) return false;
+				}
+				else if (accept("override")) {
+					if (!parseOverride(attributes)) return false;
+				}
+				else if (peek().kind == Token::Identifier) {
+					// const, alias, enable, const_assert...
+					if (!skipStatement()) return false;
+				}
+				else {
+					return fail("unexpected '" + std::string(peek().text) + "'");
+				}
+			}
+			resolveEntryPoints();
+			return true;
+		}
+
+	private:
+		struct Function
+		{
+			// Every identifier of the body, which includes the functions it
+			// calls and the globals it uses
+			std::set<std::string> names;
+		};
+
+		const Token& peek() const
+		{
+			return m_tokens[m_position];
+		}
+
+		const Token& next()
+		{
+			const Token& token = m_tokens[m_position];
+			if (token.kind != Token::End) ++m_position;
+			return token;
+		}
+
+		bool accept(std::string_view text)
+		{
+			if (peek().kind == Token::End || peek().text != text) return false;
+			++m_position;
+			return true;
+		}
+
+		bool expect(std::string_view text)
+		{
+			if (accept(text)) return true;
+			return fail("expected '" + std::string(text) + "'");
+		}
+
+		bool expectIdentifier(std::string& identifier)
+		{
+			if (peek().kind != Token::Identifier) return fail("expected a name");
+			identifier = std::string(next().text);
+			return true;
+		}
+
+		bool fail(const std::string& message) const
+		{
+			std::cerr << "WGSL line " << peek().line << ": " << message << std::endl;
+			return false;
+		}
+
+		bool parseAttributes(std::vector<Attribute>& attributes)
+		{
+			while (accept("@")) {
+				Attribute attribute;
+				if (!expectIdentifier(attribute.name)) return false;
+				if (accept("(")) {
+					std::string argument;
+					int depth = 0;
+					while (depth > 0 || peek().text != ")") {
+						const Token& token = next();
+						if (token.kind == Token::End) return fail("unterminated attribute");
+						if (token.text == "(") ++depth;
+						if (token.text == ")") --depth;
+						if (depth == 0 && token.text == ",") {
+							attribute.arguments.push_back(argument);
+							argument.clear();
+						}
+						else {
+							argument += token.text;
+						}
+					}
+					next();
+					if (!argument.empty()) attribute.arguments.push_back(argument);
+				}
+				attributes.push_back(attribute);
+			}
+			return true;
+		}
+
+		bool parseType(TypeExpr& type)
+		{
+			if (!expectIdentifier(type.name)) return false;
+			if (!accept("<")) return true;
+			do {
+				if (peek().text == ">") break;
+				TypeExpr argument;
+				if (peek().kind == Token::Number) {
+					argument.name = std::string(next().text);
+				}
+				else if (!parseType(argument)) {
+					return false;
+				}
+				type.arguments.push_back(argument);
+			} while (accept(","));
+			return expect(">");
+		}
+
+		bool skipStatement()
+		{
+			int depth = 0;
+			while (depth > 0 || peek().text != ";") {
+				const Token& token = next();
+				if (token.kind == Token::End) return fail("expected ';'");
+				if (token.text == "(" || token.text == "[" || token.text == "{") ++depth;
+				if (token.text == ")" || token.text == "]" || token.text == "}") --depth;
+			}
+			next();
+			return true;
+		}
+
+		/**
+		 * Alignment and size of a type in the uniform and storage address
+		 * spaces. A runtime-sized array counts a single element.
+		 */
+		bool layoutOf(const TypeExpr& type, uint32_t& alignment, uint32_t& size) const
+		{
+			const std::string& name = type.name;
+			if (name == "f32" || name == "i32" || name == "u32" || name == "bool" || name == "atomic") {
+				alignment = size = 4;
+				return true;
+			}
+			if (name == "f16") {
+				alignment = size = 2;
+				return true;
+			}
+
+			// vec3f or vec3<f32>, mat4x4f or mat4x4<f32>
+			const bool isVector = name.size() >= 4 && name.compare(0, 3, "vec") == 0 && isDigit(name[3]);
+			const bool isMatrix = name.size() >= 6 && name.compare(0, 3, "mat") == 0 && isDigit(name[3]) && name[4] == 'x' && isDigit(name[5]);
+			if (isVector || isMatrix) {
+				const size_t suffix = isVector ? 4 : 6;
+				uint32_t scalarSize = 4;
+				if (name.size() > suffix) {
+					scalarSize = name[suffix] == 'h' ? 2 : 4;
+				}
+				else if (!type.arguments.empty()) {
+					scalarSize = type.arguments[0].name == "f16" ? 2 : 4;
+				}
+				const uint32_t rows = static_cast<uint32_t>(name[suffix - 1] - '0');
+				const uint32_t vectorAlignment = (rows == 2 ? 2 : 4) * scalarSize;
+				const uint32_t vectorSize = rows * scalarSize;
+				alignment = vectorAlignment;
+				if (isVector) {
+					size = vectorSize;
+				}
+				else {
+					// An array of column vectors
+					const uint32_t columns = static_cast<uint32_t>(name[3] - '0');
+					size = columns * alignTo(vectorSize, vectorAlignment);
+				}
+				return true;
+			}
+
+			if (name == "array") {
+				if (type.arguments.empty()) return fail("array without element type");
+				uint32_t elementAlignment = 0, elementSize = 0;
+				if (!layoutOf(type.arguments[0], elementAlignment, elementSize)) return false;
+				uint32_t count = 1;
+				if (type.arguments.size() > 1 && !parseInteger(type.arguments[1].name, count)) {
+					return fail("array size " + type.arguments[1].name + " is not a literal");
+				}
+				alignment = elementAlignment;
+				size = count * alignTo(elementSize, elementAlignment);
+				return true;
+			}
+
+			if (const ShaderReflection::Struct* structure = m_reflection.findStruct(name)) {
+				alignment = structure->alignment;
+				size = structure->size;
+				return true;
+			}
+			return fail("unknown type " + type.text());
+		}
+
+		bool parseStruct()
+		{
+			ShaderReflection::Struct structure;
+			if (!expectIdentifier(structure.name) || !expect("{")) return false;
+			uint32_t offset = 0;
+			structure.alignment = 1;
+			while (!accept("}")) {
+				std::vector<Attribute> attributes;
+				if (!parseAttributes(attributes)) return false;
+				ShaderReflection::Member member;
+				TypeExpr type;
+				if (!expectIdentifier(member.name) || !expect(":") || !parseType(type)) return false;
+				accept(",");
+
+				uint32_t alignment = 0;
+				if (!layoutOf(type, alignment, member.size)) return false;
+				integerAttribute(attributes, "align", alignment);
+				integerAttribute(attributes, "size", member.size);
+				uint32_t location = 0;
+				if (integerAttribute(attributes, "location", location)) {
+					member.location = static_cast<int32_t>(location);
+				}
+				member.type = type.text();
+				member.offset = alignTo(offset, alignment);
+				offset = member.offset + member.size;
+				structure.alignment = std::max(structure.alignment, alignment);
+				structure.members.push_back(member);
+			}
+			structure.size = alignTo(offset, structure.alignment);
+			m_reflection.structs.push_back(structure);
+			return true;
+		}
+
+		bool parseVariable(const std::vector<Attribute>& attributes)
+		{
+			std::string addressSpace, access;
+			if (accept("<")) {
+				if (!expectIdentifier(addressSpace)) return false;
+				if (accept(",") && !expectIdentifier(access)) return false;
+				if (!expect(">")) return false;
+			}
+			std::string name;
+			TypeExpr type;
+			if (!expectIdentifier(name) || !expect(":") || !parseType(type)) return false;
+			if (!skipStatement()) return false;
+
+			uint32_t group = 0, binding = 0;
+			if (!integerAttribute(attributes, "group", group) || !integerAttribute(attributes, "binding", binding)) {
+				// Private and workgroup variables
+				return true;
+			}
+
+			ShaderReflection::Binding resource;
+			resource.name = name;
+			resource.type = type.text();
+			resource.group = group;
+			resource.layout = WGPU_BIND_GROUP_LAYOUT_ENTRY_INIT;
+			resource.layout.binding = binding;
+			resource.layout.visibility = WGPUShaderStage_None;
+			if (!describeBinding(addressSpace, access, type, resource.layout)) return false;
+			m_reflection.bindings.push_back(resource);
+			return true;
+		}
+
+		bool describeBinding(const std::string& addressSpace, const std::string& access, const TypeExpr& type, WGPUBindGroupLayoutEntry& entry) const
+		{
+			if (addressSpace == "uniform" || addressSpace == "storage") {
+				uint32_t alignment = 0, size = 0;
+				if (!layoutOf(type, alignment, size)) return false;
+				if (addressSpace == "uniform") {
+					entry.buffer.type = WGPUBufferBindingType_Uniform;
+				}
+				else {
+					entry.buffer.type = access == "read_write" ? WGPUBufferBindingType_Storage : WGPUBufferBindingType_ReadOnlyStorage;
+				}
+				entry.buffer.minBindingSize = size;
+				return true;
+			}
+			if (!addressSpace.empty()) {
+				return fail("unsupported address space " + addressSpace);
+			}
+
+			const std::string& name = type.name;
+			if (name == "sampler" || name == "sampler_comparison") {
+				entry.sampler.type = name == "sampler" ? WGPUSamplerBindingType_Filtering : WGPUSamplerBindingType_Comparison;
+				return true;
+			}
+
+			static const std::map<std::string, WGPUTextureViewDimension> dimensions = {
+				{ "1d", WGPUTextureViewDimension_1D },
+				{ "2d", WGPUTextureViewDimension_2D },
+				{ "2d_array", WGPUTextureViewDimension_2DArray },
+				{ "cube", WGPUTextureViewDimension_Cube },
+				{ "cube_array", WGPUTextureViewDimension_CubeArray },
+				{ "3d", WGPUTextureViewDimension_3D },
+			};
+			std::string dimension;
+			if (name.compare(0, 14, "texture_depth_") == 0) {
+				entry.texture.sampleType = WGPUTextureSampleType_Depth;
+				dimension = name.substr(14);
+			}
+			else if (name.compare(0, 8, "texture_") == 0 && name.compare(0, 16, "texture_storage_") != 0 && name != "texture_external") {
+				const std::string sampledType = type.arguments.empty() ? "f32" : type.arguments[0].name;
+				entry.texture.sampleType = sampledType == "i32" ? WGPUTextureSampleType_Sint
+					: sampledType == "u32" ? WGPUTextureSampleType_Uint
+					: WGPUTextureSampleType_Float;
+				dimension = name.substr(8);
+			}
+			else {
+				return fail("unsupported binding type " + type.text());
+			}
+			if (dimension.compare(0, 13, "multisampled_") == 0) {
+				entry.texture.multisampled = true;
+				dimension = dimension.substr(13);
+			}
+			auto it = dimensions.find(dimension);
+			if (it == dimensions.end()) return fail("unsupported binding type " + type.text());
+			entry.texture.viewDimension = it->second;
+			return true;
+		}
+
+		bool parseOverride(const std::vector<Attribute>& attributes)
+		{
+			ShaderReflection::Override constant;
+			if (!expectIdentifier(constant.name)) return false;
+			if (accept(":")) {
+				TypeExpr type;
+				if (!parseType(type)) return false;
+				constant.type = type.text();
+			}
+			uint32_t id = 0;
+			if (integerAttribute(attributes, "id", id)) {
+				constant.id = static_cast<int32_t>(id);
+			}
+			if (accept("=")) {
+				constant.hasDefault = true;
+				// The default value may depend on other overrides
+				std::set<std::string>& names = m_overrideNames[constant.name];
+				while (peek().text != ";") {
+					const Token& token = next();
+					if (token.kind == Token::End) return fail("expected ';'");
+					if (token.kind == Token::Identifier) names.insert(std::string(token.text));
+				}
+			}
+			if (!expect(";")) return false;
+			m_reflection.overrides.push_back(constant);
+			return true;
+		}
+
+		bool parseFunction(const std::vector<Attribute>& attributes)
+		{
+			ShaderReflection::EntryPoint entryPoint;
+			if (!expectIdentifier(entryPoint.name) || !expect("(")) return false;
+			if (findAttribute(attributes, "vertex")) entryPoint.stage = WGPUShaderStage_Vertex;
+			if (findAttribute(attributes, "fragment")) entryPoint.stage = WGPUShaderStage_Fragment;
+			if (findAttribute(attributes, "compute")) entryPoint.stage = WGPUShaderStage_Compute;
+
+			while (!accept(")")) {
+				std::vector<Attribute> parameterAttributes;
+				if (!parseAttributes(parameterAttributes)) return false;
+				ShaderReflection::VertexInput input;
+				TypeExpr type;
+				if (!expectIdentifier(input.name) || !expect(":") || !parseType(type)) return false;
+				accept(",");
+				if (entryPoint.stage != WGPUShaderStage_Vertex) continue;
+
+				input.type = type.text();
+				if (integerAttribute(parameterAttributes, "location", input.location)) {
+					entryPoint.vertexInputs.push_back(input);
+				}
+				else if (const ShaderReflection::Struct* structure = m_reflection.findStruct(type.name)) {
+					for (const ShaderReflection::Member& member : structure->members) {
+						if (member.location < 0) continue;
+						entryPoint.vertexInputs.push_back({ static_cast<uint32_t>(member.location), member.name, member.type });
+					}
+				}
+			}
+
+			if (accept("-")) {
+				std::vector<Attribute> returnAttributes;
+				TypeExpr returnType;
+				if (!expect(">") || !parseAttributes(returnAttributes) || !parseType(returnType)) return false;
+			}
+
+			if (!expect("{")) return false;
+			Function& function = m_functions[entryPoint.name];
+			int depth = 1;
+			while (depth > 0) {
+				const Token& token = next();
+				if (token.kind == Token::End) return fail("unterminated function " + entryPoint.name);
+				if (token.text == "{") ++depth;
+				if (token.text == "}") --depth;
+				if (token.kind == Token::Identifier) function.names.insert(std::string(token.text));
+			}
+
+			if (entryPoint.stage != WGPUShaderStage_None) {
+				m_reflection.entryPoints.push_back(entryPoint);
+			}
+			return true;
+		}
+
+		/**
+		 * Find the bindings and overrides each entry point uses through the
+		 * functions it calls, which WGSL allows to be declared in any order.
+		 */
+		void resolveEntryPoints()
+		{
+			for (ShaderReflection::EntryPoint& entryPoint : m_reflection.entryPoints) {
+				std::set<std::string> visited = { entryPoint.name };
+				std::vector<std::string> pending = { entryPoint.name };
+				std::set<std::string> names;
+				while (!pending.empty()) {
+					const Function& function = m_functions[pending.back()];
+					pending.pop_back();
+					for (const std::string& name : function.names) {
+						names.insert(name);
+						if (m_functions.count(name) > 0 && visited.insert(name).second) {
+							pending.push_back(name);
+						}
+					}
+				}
+				for (size_t i = 0; i < m_reflection.bindings.size(); ++i) {
+					ShaderReflection::Binding& binding = m_reflection.bindings[i];
+					if (names.count(binding.name) == 0) continue;
+					entryPoint.bindings.push_back(i);
+					binding.layout.visibility |= entryPoint.stage;
+				}
+
+				bool changed = true;
+				while (changed) {
+					changed = false;
+					for (const auto& [name, dependencies] : m_overrideNames) {
+						if (names.count(name) == 0) continue;
+						for (const std::string& dependency : dependencies) {
+							changed |= names.insert(dependency).second;
+						}
+					}
+				}
+				for (size_t i = 0; i < m_reflection.overrides.size(); ++i) {
+					if (names.count(m_reflection.overrides[i].name) > 0) entryPoint.overrides.push_back(i);
+				}
+			}
+		}
+
+		const std::vector<Token>& m_tokens;
+		size_t m_position = 0;
+		ShaderReflection& m_reflection;
+		std::map<std::string, Function> m_functions;
+		// Identifiers in the default value of each override
+		std::map<std::string, std::set<std::string>> m_overrideNames;
+	};
+
+	// 'f', 'i' or 'u': f32, vec3f, vec3<f32>, vec3h...
+	char componentKind(const std::string& type)
+	{
+		std::string scalar = type;
+		const size_t open = type.find('<');
+		if (open != std::string::npos) {
+			scalar = type.substr(open + 1, type.size() - open - 2);
+		}
+		else if (type.compare(0, 3, "vec") == 0 && type.size() > 4) {
+			scalar = type.substr(4);
+		}
+		if (scalar == "i32" || scalar == "i") return 'i';
+		if (scalar == "u32" || scalar == "u") return 'u';
+		return 'f';
+	}
+
+	char componentKind(WGPUVertexFormat format)
+	{
+		switch (format) {
+		case WGPUVertexFormat_Uint8:
+		case WGPUVertexFormat_Uint8x2:
+		case WGPUVertexFormat_Uint8x4:
+		case WGPUVertexFormat_Uint16:
+		case WGPUVertexFormat_Uint16x2:
+		case WGPUVertexFormat_Uint16x4:
+		case WGPUVertexFormat_Uint32:
+		case WGPUVertexFormat_Uint32x2:
+		case WGPUVertexFormat_Uint32x3:
+		case WGPUVertexFormat_Uint32x4:
+			return 'u';
+		case WGPUVertexFormat_Sint8:
+		case WGPUVertexFormat_Sint8x2:
+		case WGPUVertexFormat_Sint8x4:
+		case WGPUVertexFormat_Sint16:
+		case WGPUVertexFormat_Sint16x2:
+		case WGPUVertexFormat_Sint16x4:
+		case WGPUVertexFormat_Sint32:
+		case WGPUVertexFormat_Sint32x2:
+		case WGPUVertexFormat_Sint32x3:
+		case WGPUVertexFormat_Sint32x4:
+			return 'i';
+		default:
+			// Float, unorm and snorm formats
+			return 'f';
+		}
+	}
+}
+
+const ShaderReflection::Struct* ShaderReflection::findStruct(const std::string& name) const
+{
+	for (const Struct& structure : structs) {
+		if (structure.name == name) return &structure;
+	}
+	return nullptr;
+}
+
+const ShaderReflection::Binding* ShaderReflection::findBinding(uint32_t group, uint32_t binding) const
+{
+	for (const Binding& resource : bindings) {
+		if (resource.group == group && resource.layout.binding == binding) return &resource;
+	}
+	return nullptr;
+}
+
+const ShaderReflection::EntryPoint* ShaderReflection::findEntryPoint(const std::string& name) const
+{
+	for (const EntryPoint& entryPoint : entryPoints) {
+		if (entryPoint.name == name) return &entryPoint;
+	}
+	return nullptr;
+}
+
+std::vector<WGPUBindGroupLayoutEntry> ShaderReflection::bindGroupLayoutEntries(uint32_t group) const
+{
+	std::vector<WGPUBindGroupLayoutEntry> entries;
+	for (const Binding& resource : bindings) {
+		// Bindings that no entry point uses are left out of the layout
+		if (resource.group == group && resource.layout.visibility != WGPUShaderStage_None) {
+			entries.push_back(resource.layout);
+		}
+	}
+	std::sort(entries.begin(), entries.end(), [](const WGPUBindGroupLayoutEntry& a, const WGPUBindGroupLayoutEntry& b) {
+		return a.binding < b.binding;
+	});
+	return entries;
+}
+
+uint32_t ShaderReflection::bindGroupCount(const std::vector<std::string>& entryPointNames) const
+{
+	uint32_t count = 0;
+	for (const std::string& name : entryPointNames) {
+		const EntryPoint* entryPoint = findEntryPoint(name);
+		if (entryPoint == nullptr) continue;
+		for (size_t index : entryPoint->bindings) {
+			count = std::max(count, bindings[index].group + 1);
+		}
+	}
+	return count;
+}
+
+bool ShaderReflection::checkVertexInputs(const std::string& entryPointName, size_t bufferCount, const WGPUVertexBufferLayout* buffers) const
+{
+	const EntryPoint* entryPoint = findEntryPoint(entryPointName);
+	if (entryPoint == nullptr || entryPoint->stage != WGPUShaderStage_Vertex) {
+		std::cerr << "No vertex entry point " << entryPointName << " in the shader" << std::endl;
+		return false;
+	}
+
+	bool matches = true;
+	for (const VertexInput& input : entryPoint->vertexInputs) {
+		const WGPUVertexAttribute* attribute = nullptr;
+		for (size_t i = 0; i < bufferCount && attribute == nullptr; ++i) {
+			for (size_t j = 0; j < buffers[i].attributeCount; ++j) {
+				if (buffers[i].attributes[j].shaderLocation == input.location) {
+					attribute = &buffers[i].attributes[j];
+					break;
+				}
+			}
+		}
+		if (attribute == nullptr) {
+			std::cerr << "Vertex input " << input.name << " (@location(" << input.location << ")) of " << entryPointName << " has no attribute" << std::endl;
+			matches = false;
+		}
+		else if (componentKind(attribute->format) != componentKind(input.type)) {
+			std::cerr << "Vertex input " << input.name << " (@location(" << input.location << ")) of " << entryPointName << " is a " << input.type << ", which its attribute format cannot provide" << std::endl;
+			matches = false;
+		}
+	}
+	return matches;
+}
+
+bool ShaderReflection::stageConstants(const std::string& entryPointName, const std::vector<PipelineConstant>& values, std::vector<PipelineConstant>& constants) const
+{
+	constants.clear();
+	const EntryPoint* entryPoint = findEntryPoint(entryPointName);
+	if (entryPoint == nullptr) {
+		std::cerr << "No entry point " << entryPointName << " in the shader" << std::endl;
+		return false;
+	}
+
+	bool complete = true;
+	for (size_t index : entryPoint->overrides) {
+		const Override& constant = overrides[index];
+		auto value = std::find_if(values.begin(), values.end(), [&](const PipelineConstant& v) {
+			return v.key == constant.name;
+		});
+		if (value == values.end()) {
+			if (!constant.hasDefault) {
+				std::cerr << "Override " << constant.name << " of " << entryPointName << " has no value" << std::endl;
+				complete = false;
+			}
+			continue;
+		}
+		const std::string key = constant.id >= 0 ? std::to_string(constant.id) : constant.name;
+		constants.push_back({ key, value->value });
+	}
+	return complete;
+}
+
+bool ShaderReflector::reflect(const std::string& source, ShaderReflection& reflection)
+{
+	reflection = ShaderReflection();
+	std::vector<Token> tokens;
+	if (!tokenize(source, tokens)) return false;
+	return Parser(tokens, reflection).parse();
+}
@@ -0,0 +1,148 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <webgpu/webgpu.h>
+
+/**
+ * Value of a pipeline-overridable constant (`override` in WGSL) for one
+ * stage of a pipeline. Booleans are 0 or 1.
+ */
+struct PipelineConstant
+{
+	// Name of the override. Given to a stage, its @id when it has one.
+	std::string key;
+	double value = 0.0;
+
+	bool operator==(const PipelineConstant& other) const { return key == other.key && value == other.value; }
+};
+
+/**
+ * What a WGSL module declares that the host side must agree with: the
+ * layout of its structs, its resource bindings and the vertex inputs of its
+ * entry points. Bind group layouts are generated from it rather than
+ * written by hand, so that they cannot drift from the shader, and so are
+ * the constants given to each stage.
+ */
+struct ShaderReflection
+{
+	struct Member
+	{
+		std::string name;
+		std::string type;
+		// Offset and size in the host-shareable layout (uniform and storage)
+		uint32_t offset = 0;
+		uint32_t size = 0;
+		// @location, or -1
+		int32_t location = -1;
+	};
+
+	struct Struct
+	{
+		std::string name;
+		std::vector<Member> members;
+		uint32_t alignment = 0;
+		uint32_t size = 0;
+	};
+
+	struct Binding
+	{
+		std::string name;
+		std::string type;
+		uint32_t group = 0;
+		// Layout entry of the binding, visible to the stage of every entry
+		// point of the module that uses it. The minimum binding size counts a
+		// single element of a runtime-sized array.
+		WGPUBindGroupLayoutEntry layout;
+	};
+
+	struct Override
+	{
+		std::string name;
+		// Empty when inferred from the default value
+		std::string type;
+		// @id, or -1
+		int32_t id = -1;
+		// Without one, every pipeline using it must set it
+		bool hasDefault = false;
+	};
+
+	struct VertexInput
+	{
+		uint32_t location = 0;
+		std::string name;
+		std::string type;
+	};
+
+	struct EntryPoint
+	{
+		std::string name;
+		WGPUShaderStage stage = WGPUShaderStage_None;
+		// Vertex entry points only, either parameters or struct members
+		std::vector<VertexInput> vertexInputs;
+		// Indices in `bindings` of the bindings it uses, directly or through
+		// the functions it calls
+		std::vector<size_t> bindings;
+		// Indices in `overrides` of the overrides it uses, the same way, or
+		// through the default value of another one
+		std::vector<size_t> overrides;
+	};
+
+	std::vector<Struct> structs;
+	std::vector<Binding> bindings;
+	std::vector<Override> overrides;
+	std::vector<EntryPoint> entryPoints;
+
+	const Struct* findStruct(const std::string& name) const;
+	const Binding* findBinding(uint32_t group, uint32_t binding) const;
+	const EntryPoint* findEntryPoint(const std::string& name) const;
+
+	/**
+	 * Entries of bind group `group`, sorted by binding. Groups in between
+	 * used ones are empty.
+	 */
+	std::vector<WGPUBindGroupLayoutEntry> bindGroupLayoutEntries(uint32_t group) const;
+
+	/**
+	 * Number of bind groups a pipeline made of `entryPoints` needs, i.e. one
+	 * more than the highest group they use.
+	 */
+	uint32_t bindGroupCount(const std::vector<std::string>& entryPoints) const;
+
+	/**
+	 * Whether the vertex buffers of a pipeline provide every input of the
+	 * vertex entry point with a compatible format. Mismatches are reported.
+	 */
+	bool checkVertexInputs(const std::string& entryPoint, size_t bufferCount, const WGPUVertexBufferLayout* buffers) const;
+
+	/**
+	 * Constants of a pipeline stage running `entryPoint`, from the values of
+	 * overrides by name in `values`. Values of overrides the entry point does
+	 * not use are left out, since a stage rejects them, so the same values
+	 * can be given to every stage. Used overrides that have neither a value
+	 * nor a default are reported, in which case false is returned.
+	 */
+	bool stageConstants(const std::string& entryPoint, const std::vector<PipelineConstant>& values, std::vector<PipelineConstant>& constants) const;
+};
+
+/**
+ * A lightweight WGSL front end that only reads declarations: it skips
+ * function bodies except for the names they use, and does not validate
+ * anything the compiler validates anyway. Runs on the preprocessed source
+ * (see ShaderPreprocessor).
+ *
+ * Supported resources are uniform and storage buffers, sampled textures and
+ * samplers. Overrides used only in the sizes of workgroup arrays are not
+ * seen. Structs must be declared before they are used, and fixed array
+ * sizes must be literals.
+ */
+class ShaderReflector
+{
+public:
+	/**
+	 * Reflect `source`. Report unsupported declarations with their line and
+	 * return false.
+	 */
+	static bool reflect(const std::string& source, ShaderReflection& reflection);
+};
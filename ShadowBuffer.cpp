@@ -0,0 +1,74 @@
+#include "ShadowBuffer.h"
+#include "webgpu-utils.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+ShadowBuffer::ShadowBuffer(WGPUDevice device, WGPUQueue queue, uint64_t size, WGPUBufferUsage usage, const char* label)
+	: m_queue(queue)
+	, m_shadow((size + 3) & ~uint64_t(3), 0)
+{
+	WGPUBufferDescriptor bufferDesc = WGPU_BUFFER_DESCRIPTOR_INIT;
+	bufferDesc.label = toWgpuStringView(label);
+	bufferDesc.size = m_shadow.size();
+	bufferDesc.usage = usage | WGPUBufferUsage_CopyDst;
+	m_buffer = wgpuDeviceCreateBuffer(device, &bufferDesc);
+}
+
+ShadowBuffer::~ShadowBuffer()
+{
+	if (m_buffer) wgpuBufferRelease(m_buffer);
+}
+
+bool ShadowBuffer::write(uint64_t offset, const void* data, uint64_t size)
+{
+	if (offset > m_shadow.size() || size > m_shadow.size() - offset) {
+		std::cerr << "Writing " << size << " bytes at " << offset << " past the end of a " << m_shadow.size() << " bytes buffer" << std::endl;
+		return false;
+	}
+
+	// Only the part between the first and the last changed byte is dirty
+	const uint8_t* bytes = static_cast<const uint8_t*>(data);
+	uint8_t* shadow = m_shadow.data() + offset;
+	uint64_t begin = 0;
+	while (begin < size && bytes[begin] == shadow[begin]) ++begin;
+	if (begin == size) {
+		m_stats.unchangedBytes += size;
+		return true;
+	}
+	uint64_t end = size;
+	while (bytes[end - 1] == shadow[end - 1]) --end;
+
+	std::memcpy(shadow + begin, bytes + begin, end - begin);
+	m_stats.unchangedBytes += size - (end - begin);
+	m_dirtyRanges.push_back({ offset + begin, offset + end });
+	return true;
+}
+
+void ShadowBuffer::flush()
+{
+	if (m_dirtyRanges.empty()) return;
+	std::sort(m_dirtyRanges.begin(), m_dirtyRanges.end());
+
+	// Queue writes start and end on multiples of 4, which the shadow size is
+	auto upload = [this](uint64_t begin, uint64_t end) {
+		begin &= ~uint64_t(3);
+		end = std::min<uint64_t>((end + 3) & ~uint64_t(3), m_shadow.size());
+		wgpuQueueWriteBuffer(m_queue, m_buffer, begin, m_shadow.data() + begin, end - begin);
+		++m_stats.uploadCount;
+		m_stats.uploadedBytes += end - begin;
+	};
+
+	uint64_t begin = m_dirtyRanges.front().first;
+	uint64_t end = m_dirtyRanges.front().second;
+	for (const auto& [rangeBegin, rangeEnd] : m_dirtyRanges) {
+		if (rangeBegin > end + MergeGap) {
+			upload(begin, end);
+			begin = rangeBegin;
+		}
+		end = std::max(end, rangeEnd);
+	}
+	upload(begin, end);
+	m_dirtyRanges.clear();
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include <webgpu/webgpu.h>
+
+/**
+ * A GPU buffer with a copy of its content on the CPU side, for data that is
+ * written on every frame but mostly stays the same (uniforms, instances).
+ * write() only marks the bytes that actually change as dirty, and flush()
+ * uploads them once per frame with as few queue writes as possible.
+ *
+ * Dirty ranges are merged when they overlap, touch or are separated by
+ * at most MergeGap bytes, since uploading a few unchanged bytes is
+ * cheaper than issuing another write.
+ */
+class ShadowBuffer
+{
+public:
+	// Largest gap between two dirty ranges uploaded as one
+	static constexpr uint64_t MergeGap = 64;
+
+	struct Stats
+	{
+		// Queue writes issued by flush(), and the bytes they uploaded
+		uint64_t uploadCount = 0;
+		uint64_t uploadedBytes = 0;
+		// Bytes passed to write() that were already up to date
+		uint64_t unchangedBytes = 0;
+	};
+
+	/**
+	 * `usage` does not need to include CopyDst. The size is rounded up to a
+	 * multiple of 4, the granularity of queue writes.
+	 */
+	ShadowBuffer(WGPUDevice device, WGPUQueue queue, uint64_t size, WGPUBufferUsage usage, const char* label);
+	~ShadowBuffer();
+
+	ShadowBuffer(const ShadowBuffer&) = delete;
+	ShadowBuffer& operator=(const ShadowBuffer&) = delete;
+
+	WGPUBuffer buffer() const { return m_buffer; }
+	uint64_t size() const { return m_shadow.size(); }
+
+	/**
+	 * Copy `size` bytes at `offset` in the shadow copy, and mark those that
+	 * differ as dirty. Return false if the range is out of the buffer,
+	 * which is reported.
+	 */
+	bool write(uint64_t offset, const void* data, uint64_t size);
+
+	/**
+	 * Upload the dirty ranges, if any.
+	 */
+	void flush();
+
+	const Stats& stats() const { return m_stats; }
+
+private:
+	WGPUQueue m_queue;
+	WGPUBuffer m_buffer = nullptr;
+	// Starts zeroed, like the buffer
+	std::vector<uint8_t> m_shadow;
+	// Begin and end of each range marked since the last flush()
+	std::vector<std::pair<uint64_t, uint64_t>> m_dirtyRanges;
+	Stats m_stats;
+};
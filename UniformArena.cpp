@@ -0,0 +1,60 @@
+#include "UniformArena.h"
+
+#include <iostream>
+
+namespace
+{
+	uint32_t uniformOffsetAlignment(WGPUDevice device)
+	{
+		WGPULimits limits = WGPU_LIMITS_INIT;
+#ifdef WEBGPU_BACKEND_DAWN
+		bool success = wgpuDeviceGetLimits(device, &limits) & WGPUStatus_Success;
+#else
+		bool success = wgpuDeviceGetLimits(device, &limits);
+#endif
+		// Otherwise use the default limit, which every device supports
+		if (success && limits.minUniformBufferOffsetAlignment > 0) {
+			return limits.minUniformBufferOffsetAlignment;
+		}
+		return 256;
+	}
+}
+
+UniformArena::UniformArena(WGPUDevice device, WGPUQueue queue, uint64_t maxBlockSize, size_t blockCount)
+	: m_alignment(uniformOffsetAlignment(device))
+	, m_shadow(device, queue, blockSize(maxBlockSize) * blockCount, WGPUBufferUsage_Uniform, "Uniform arena")
+{}
+
+uint64_t UniformArena::blockSize(uint64_t size) const
+{
+	return (size + m_alignment - 1) / m_alignment * m_alignment;
+}
+
+void UniformArena::reset()
+{
+	m_used = 0;
+	m_full = false;
+}
+
+uint32_t UniformArena::allocate(const void* data, uint32_t size)
+{
+	const uint64_t offset = m_used;
+	// Dynamic offsets are 32-bit
+	if (offset + size > m_shadow.size() || offset >= InvalidOffset) {
+		if (!m_full) {
+			std::cerr << "Uniform arena is full (" << m_shadow.size() << " bytes)" << std::endl;
+		}
+		m_full = true;
+		return InvalidOffset;
+	}
+	m_shadow.write(offset, data, size);
+	m_used = offset + blockSize(size);
+	return static_cast<uint32_t>(offset);
+}
+
+void UniformArena::upload()
+{
+	// Blocks keep their offset from one frame to the next as long as the
+	// same objects are drawn in the same order, so most of them are skipped
+	m_shadow.flush();
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <webgpu/webgpu.h>
+#include "ShadowBuffer.h"
+
+/**
+ * Uniforms of a frame, suballocated linearly from a single buffer and
+ * uploaded with a single write. Each block starts at a multiple of the
+ * device's minUniformBufferOffsetAlignment so that it can be bound with a
+ * dynamic offset: one bind group serves every draw, which only passes the
+ * offset of its block to SetBindGroup.
+ *
+ * Blocks are copied to the shadow copy of the buffer until upload(), which
+ * only sends the bytes that differ from the previous frame (see
+ * ShadowBuffer). The buffer is then overwritten on the next frame, which is
+ * safe since queue writes and submissions execute in order: the draws of a
+ * frame have read the buffer before the write of the next one lands.
+ */
+class UniformArena
+{
+public:
+	// Returned by allocate() when the arena is full
+	static constexpr uint32_t InvalidOffset = UINT32_MAX;
+
+	/**
+	 * Room for `blockCount` blocks of up to `maxBlockSize` bytes each.
+	 */
+	UniformArena(WGPUDevice device, WGPUQueue queue, uint64_t maxBlockSize, size_t blockCount);
+
+	UniformArena(const UniformArena&) = delete;
+	UniformArena& operator=(const UniformArena&) = delete;
+
+	WGPUBuffer buffer() const { return m_shadow.buffer(); }
+	uint32_t alignment() const { return m_alignment; }
+	// Size taken by a block of `size` bytes, i.e. `size` rounded up to the alignment
+	uint64_t blockSize(uint64_t size) const;
+
+	/**
+	 * Start a new frame, whose blocks replace the ones of the previous frame.
+	 */
+	void reset();
+
+	/**
+	 * Copy `size` bytes to a new block and return its offset, or
+	 * InvalidOffset if there is no room left, which is reported.
+	 */
+	uint32_t allocate(const void* data, uint32_t size);
+
+	template <typename T>
+	uint32_t allocate(const T& block)
+	{
+		return allocate(&block, static_cast<uint32_t>(sizeof(T)));
+	}
+
+	/**
+	 * Write the blocks that changed since the last upload to the buffer.
+	 */
+	void upload();
+
+	uint64_t capacity() const { return m_shadow.size(); }
+	uint64_t usedSize() const { return m_used; }
+	const ShadowBuffer::Stats& uploadStats() const { return m_shadow.stats(); }
+
+private:
+	// Initialized before m_shadow, whose size depends on it
+	uint32_t m_alignment;
+	ShadowBuffer m_shadow;
+	uint64_t m_used = 0;
+	// Overflows are only reported once per frame
+	bool m_full = false;
+};
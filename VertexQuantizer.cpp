@@ -0,0 +1,125 @@
+#include "VertexQuantizer.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+	// Size in bytes of a quantized vertex: Float16x4 or Snorm16x4, then Unorm8x4
+	constexpr uint32_t PositionSize = 4 * sizeof(uint16_t);
+	constexpr uint32_t ColorSize = 4 * sizeof(uint8_t);
+}
+
+std::vector<uint8_t> VertexQuantizer::quantize(
+	const std::vector<float>& pointData,
+	int dimensions,
+	GeometryProcessing processing,
+	VertexLayout& layout,
+	const MeshBounds* bounds
+)
+{
+	const bool snorm = (processing & GeometryProcessing_QuantizeSnorm16) != 0;
+	if (!snorm && (processing & GeometryProcessing_QuantizeHalf) == 0) return {};
+
+	const size_t stride = static_cast<size_t>(dimensions) + 3;
+	const size_t vertexCount = pointData.size() / stride;
+
+	// Bounding box of the positions, 0 for an empty mesh
+	MeshBounds pointBounds = bounds ? *bounds : MeshBounds::fromPoints(pointData.data(), vertexCount, dimensions);
+	std::array<float, 3> boxMin = { 0.0f, 0.0f, 0.0f };
+	std::array<float, 3> boxMax = { 0.0f, 0.0f, 0.0f };
+	if (!pointBounds.empty()) {
+		boxMin = pointBounds.boxMin;
+		boxMax = pointBounds.boxMax;
+	}
+
+	layout = VertexLayout();
+	layout.positionFormat = snorm ? WGPUVertexFormat_Snorm16x4 : WGPUVertexFormat_Float16x4;
+	layout.colorFormat = WGPUVertexFormat_Unorm8x4;
+	layout.positionOffset = 0;
+	layout.colorOffset = PositionSize;
+	layout.stride = PositionSize + ColorSize;
+	for (int c = 0; c < 3; ++c) {
+		layout.positionBias[c] = 0.5f * (boxMin[c] + boxMax[c]);
+		// A flat axis keeps a unit scale so that decoding never divides by 0
+		float halfExtent = 0.5f * (boxMax[c] - boxMin[c]);
+		layout.positionScale[c] = snorm && halfExtent > 0.0f ? halfExtent : 1.0f;
+	}
+	layout.positionScale[3] = 1.0f;
+	layout.positionBias[3] = 0.0f;
+
+	std::vector<uint8_t> vertexData(vertexCount * layout.stride);
+	for (size_t v = 0; v < vertexCount; ++v) {
+		const float* p = pointData.data() + v * stride;
+		uint8_t* out = vertexData.data() + v * layout.stride;
+
+		std::array<uint16_t, 4> position = { 0, 0, 0, 0 };
+		for (int c = 0; c < dimensions && c < 3; ++c) {
+			float relative = (p[c] - layout.positionBias[c]) / layout.positionScale[c];
+			position[c] = snorm
+				? static_cast<uint16_t>(floatToSnorm16(relative))
+				: floatToHalf(relative);
+		}
+		std::memcpy(out + layout.positionOffset, position.data(), PositionSize);
+
+		const float* color = p + dimensions;
+		std::array<uint8_t, 4> packedColor = {
+			floatToUnorm8(color[0]),
+			floatToUnorm8(color[1]),
+			floatToUnorm8(color[2]),
+			255
+		};
+		std::memcpy(out + layout.colorOffset, packedColor.data(), ColorSize);
+	}
+	return vertexData;
+}
+
+uint16_t VertexQuantizer::floatToHalf(float value)
+{
+	uint32_t bits;
+	std::memcpy(&bits, &value, sizeof(bits));
+
+	const uint32_t sign = (bits >> 16) & 0x8000;
+	const uint32_t absBits = bits & 0x7FFFFFFF;
+
+	// NaN stays a (quiet) NaN, infinity stays infinity
+	if (absBits >= 0x7F800000) {
+		return static_cast<uint16_t>(sign | 0x7C00 | (absBits > 0x7F800000 ? 0x0200 : 0));
+	}
+	// Overflow: 65520 and above round to infinity
+	if (absBits >= 0x477FF000) {
+		return static_cast<uint16_t>(sign | 0x7C00);
+	}
+	// Normal half
+	if (absBits >= 0x38800000) {
+		uint32_t mantissaRounded = absBits + 0xFFF + ((absBits >> 13) & 1);
+		return static_cast<uint16_t>(sign | ((mantissaRounded - 0x38000000) >> 13));
+	}
+	// Subnormal half (or zero): shift the mantissa, with its implicit bit, by
+	// the exponent difference and round to nearest even
+	if (absBits >= 0x33000000) {
+		const uint32_t exponent = absBits >> 23;
+		const uint32_t mantissa = (absBits & 0x007FFFFF) | 0x00800000;
+		const uint32_t shift = 126 - exponent;
+		uint32_t half = mantissa >> shift;
+		const uint32_t remainder = mantissa & ((1u << shift) - 1);
+		const uint32_t halfway = 1u << (shift - 1);
+		if (remainder > halfway || (remainder == halfway && (half & 1))) ++half;
+		return static_cast<uint16_t>(sign | half);
+	}
+	return static_cast<uint16_t>(sign);
+}
+
+int16_t VertexQuantizer::floatToSnorm16(float value)
+{
+	float clamped = std::min(std::max(value, -1.0f), 1.0f);
+	return static_cast<int16_t>(std::lround(clamped * 32767.0f));
+}
+
+uint8_t VertexQuantizer::floatToUnorm8(float value)
+{
+	float clamped = std::min(std::max(value, 0.0f), 1.0f);
+	return static_cast<uint8_t>(std::lround(clamped * 255.0f));
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Geometry.h"
+
+/**
+ * Vertex compression, turning the interleaved float points produced by the
+ * parser (`dimensions` position floats then 3 color floats per vertex) into
+ * a 12-byte vertex:
+ *  - position as Float16x4, relative to the center of the mesh AABB so that
+ *    half floats keep their precision on meshes far from the origin, or as
+ *    Snorm16x4 normalized to the AABB, which has uniform precision;
+ *  - color as Unorm8x4, with an opaque alpha.
+ *
+ * The returned VertexLayout carries the scale and bias the vertex shader
+ * uses to get back to model space.
+ */
+class VertexQuantizer
+{
+public:
+	/**
+	 * Encode `pointData` according to the quantization flags of `processing`
+	 * (GeometryProcessing_QuantizeSnorm16 wins over _QuantizeHalf) and fill
+	 * `layout` accordingly. Return an empty vector if no flag is set.
+	 * `bounds`, if the parser already computed them, saves a pass over the
+	 * points.
+	 */
+	static std::vector<uint8_t> quantize(
+		const std::vector<float>& pointData,
+		int dimensions,
+		GeometryProcessing processing,
+		VertexLayout& layout,
+		const MeshBounds* bounds = nullptr
+	);
+
+	/**
+	 * IEEE 754 binary32 to binary16 conversion, rounding to nearest even.
+	 */
+	static uint16_t floatToHalf(float value);
+
+	static int16_t floatToSnorm16(float value);
+	static uint8_t floatToUnorm8(float value);
+};
@@ -0,0 +1,181 @@
+// Throughput benchmark of the text geometry parser.
+//
+// Usage: GeometryBench [vertexCount] [repeat] [maxThreads]
+//
+// Generates a pyramid.txt-style file with `vertexCount` points (2M by
+// default) in the temporary directory, then compares the MB/s of the
+// original std::istringstream parser with GeometryParser, and reports how
+// GeometryParser scales from 1 to `maxThreads` threads (32 by default).
+#include "GeometryParser.h"
+#include "MappedFile.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	constexpr int Dimensions = 3;
+
+	// The parser ResourceManager::loadGeometry used before GeometryParser,
+	// kept as the baseline to compare against.
+	bool referenceLoadGeometry(const std::filesystem::path& path, std::vector<float>& pointData, std::vector<uint16_t>& indexData, int dimensions)
+	{
+		std::ifstream file(path);
+		if (!file.is_open()) {
+			return false;
+		}
+
+		pointData.clear();
+		indexData.clear();
+
+		enum class Section {
+			None,
+			Points,
+			Indices,
+		};
+		Section currentSection = Section::None;
+
+		float value;
+		uint16_t index;
+		std::string line;
+		while (!file.eof()) {
+			getline(file, line);
+
+			if (!line.empty() && line.back() == '\r') {
+				line.pop_back();
+			}
+
+			if (line == "[points]") {
+				currentSection = Section::Points;
+			}
+			else if (line == "[indices]") {
+				currentSection = Section::Indices;
+			}
+			else if (line[0] == '#' || line.empty()) {
+			}
+			else if (currentSection == Section::Points) {
+				std::istringstream iss(line);
+				for (int i = 0; i < dimensions + 3; ++i) {
+					iss >> value;
+					pointData.push_back(value);
+				}
+			}
+			else if (currentSection == Section::Indices) {
+				std::istringstream iss(line);
+				for (int i = 0; i < 3; ++i) {
+					iss >> index;
+					indexData.push_back(index);
+				}
+			}
+		}
+		return true;
+	}
+
+	bool fastLoadGeometry(const std::filesystem::path& path, std::vector<float>& pointData, std::vector<uint16_t>& indexData, int dimensions, unsigned threadCount)
+	{
+		MappedFile file;
+		if (!file.open(path)) {
+			return false;
+		}
+		const char* begin = reinterpret_cast<const char*>(file.data());
+		GeometryParser::parse(begin, begin + file.size(), pointData, indexData, dimensions, threadCount);
+		return true;
+	}
+
+	void generateGeometry(const std::filesystem::path& path, size_t vertexCount)
+	{
+		std::ofstream file(path, std::ios::binary);
+		std::mt19937 rng(42);
+		std::uniform_real_distribution<float> position(-1.0f, 1.0f);
+		std::uniform_real_distribution<float> color(0.0f, 1.0f);
+		std::uniform_int_distribution<int> corner(0, 65535);
+
+		file << "# Generated by GeometryBench\n[points]\n# x y z r g b\n";
+		for (size_t i = 0; i < vertexCount; ++i) {
+			file << position(rng) << ' ' << position(rng) << ' ' << position(rng) << "    "
+				<< color(rng) << ' ' << color(rng) << ' ' << color(rng) << '\n';
+		}
+		file << "\n[indices]\n";
+		for (size_t i = 0; i < vertexCount; ++i) {
+			file << corner(rng) << ' ' << corner(rng) << ' ' << corner(rng) << '\n';
+		}
+	}
+
+	using Loader = std::function<bool(const std::filesystem::path&, std::vector<float>&, std::vector<uint16_t>&, int)>;
+
+	double measure(const char* name, const Loader& loader, const std::filesystem::path& path, int repeat, std::vector<float>& pointData, std::vector<uint16_t>& indexData)
+	{
+		double bestSeconds = 1e30;
+		for (int i = 0; i < repeat; ++i) {
+			auto start = std::chrono::steady_clock::now();
+			loader(path, pointData, indexData, Dimensions);
+			std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+			if (elapsed.count() < bestSeconds) bestSeconds = elapsed.count();
+		}
+		double megabytes = static_cast<double>(std::filesystem::file_size(path)) / (1024.0 * 1024.0);
+		std::cout << name << ": " << bestSeconds * 1000.0 << " ms, " << megabytes / bestSeconds << " MB/s" << std::endl;
+		return bestSeconds;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	size_t vertexCount = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 2'000'000;
+	int repeat = argc > 2 ? std::atoi(argv[2]) : 3;
+	unsigned maxThreads = argc > 3 ? static_cast<unsigned>(std::atoi(argv[3])) : 32;
+
+	std::filesystem::path path = std::filesystem::temp_directory_path() / "GeometryBench.txt";
+	generateGeometry(path, vertexCount);
+	std::cout << "Generated " << vertexCount << " vertices, "
+		<< std::filesystem::file_size(path) / (1024 * 1024) << " MB" << std::endl;
+
+	std::vector<float> referencePoints, fastPoints;
+	std::vector<uint16_t> referenceIndices, fastIndices;
+	double referenceSeconds = measure("istringstream", referenceLoadGeometry, path, repeat, referencePoints, referenceIndices);
+	auto serialLoader = [](const std::filesystem::path& p, std::vector<float>& points, std::vector<uint16_t>& indices, int dimensions) {
+		return fastLoadGeometry(p, points, indices, dimensions, 1);
+	};
+	double fastSeconds = measure("from_chars   ", serialLoader, path, repeat, fastPoints, fastIndices);
+	std::cout << "Speedup: " << referenceSeconds / fastSeconds << "x" << std::endl;
+
+	bool identical = referencePoints == fastPoints && referenceIndices == fastIndices;
+	if (!identical) {
+		std::cerr << "Parsers disagree!" << std::endl;
+	}
+
+	// Scaling of the chunked parser. Outputs are compared bit for bit with the
+	// serial run, not just for equality, so that -0.0 and NaN payloads count.
+	std::cout << std::endl << "Threads (" << std::thread::hardware_concurrency() << " hardware):" << std::endl;
+	std::vector<float> parallelPoints;
+	std::vector<uint16_t> parallelIndices;
+	for (unsigned threadCount = 1; threadCount <= maxThreads; threadCount *= 2) {
+		auto parallelLoader = [threadCount](const std::filesystem::path& p, std::vector<float>& points, std::vector<uint16_t>& indices, int dimensions) {
+			return fastLoadGeometry(p, points, indices, dimensions, threadCount);
+		};
+		std::string name = "  " + std::to_string(threadCount) + " thread(s)";
+		double seconds = measure(name.c_str(), parallelLoader, path, repeat, parallelPoints, parallelIndices);
+		std::cout << "    scaling: " << fastSeconds / seconds << "x" << std::endl;
+
+		bool bitIdentical =
+			parallelPoints.size() == fastPoints.size() &&
+			parallelIndices == fastIndices &&
+			std::memcmp(parallelPoints.data(), fastPoints.data(), fastPoints.size() * sizeof(float)) == 0;
+		if (!bitIdentical) {
+			std::cerr << "Parallel output differs from serial output!" << std::endl;
+			identical = false;
+		}
+	}
+
+	std::filesystem::remove(path);
+	return identical ? 0 : 1;
+}
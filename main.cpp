@@ -1,13 +1,90 @@
 // In main.cpp
 #include "Application.h"
 
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
 #ifdef __EMSCRIPTEN__
 #  include <emscripten.h>
 #endif // __EMSCRIPTEN__
 
-int main() {
+namespace
+{
+	// Command line flags selecting the post-load processing of the geometry
+	struct ProcessingFlag
+	{
+		const char* name;
+		GeometryProcessing processing;
+	};
+	const ProcessingFlag ProcessingFlags[] = {
+		{ "--optimize", GeometryProcessing_Optimize },
+		{ "--quantize-half", GeometryProcessing_QuantizeHalf },
+		{ "--quantize-snorm16", GeometryProcessing_QuantizeSnorm16 },
+		{ "--meshlets", GeometryProcessing_Meshlets },
+		{ "--lods", GeometryProcessing_Lods },
+	};
+
+	// Parse the value of `--objects`, a strictly positive number of copies
+	bool parseObjectCount(const char* value, size_t& objectCount)
+	{
+		char* end = nullptr;
+		errno = 0;
+		const unsigned long long count = std::strtoull(value, &end, 10);
+		if (end == value || *end != '\0' || value[0] == '-' || errno == ERANGE || count == 0) {
+			std::cerr << "Invalid number of objects " << value << ", expected a positive integer" << std::endl;
+			return false;
+		}
+		objectCount = static_cast<size_t>(count);
+		return true;
+	}
+
+	bool parseArguments(int argc, char* argv[], GeometryProcessing& processing, size_t& objectCount)
+	{
+		processing = GeometryProcessing_None;
+		for (int i = 1; i < argc; ++i) {
+			if (std::strcmp(argv[i], "--objects") == 0) {
+				if (i + 1 == argc) {
+					std::cerr << "Missing value after --objects" << std::endl;
+					return false;
+				}
+				if (!parseObjectCount(argv[++i], objectCount)) {
+					return false;
+				}
+				continue;
+			}
+			bool known = false;
+			for (const ProcessingFlag& flag : ProcessingFlags) {
+				if (std::strcmp(argv[i], flag.name) == 0) {
+					processing |= flag.processing;
+					known = true;
+				}
+			}
+			if (!known) {
+				std::cerr << "Unknown argument " << argv[i] << ", expected any of:";
+				for (const ProcessingFlag& flag : ProcessingFlags) {
+					std::cerr << " " << flag.name;
+				}
+				std::cerr << " --objects <count>" << std::endl;
+				return false;
+			}
+		}
+		return true;
+	}
+}
+
+int main(int argc, char* argv[]) {
 	Application app;
 
+	GeometryProcessing processing;
+	size_t objectCount = 1;
+	if (!parseArguments(argc, argv, processing, objectCount)) {
+		return 1;
+	}
+	app.SetGeometryProcessing(processing);
+	app.SetObjectCount(objectCount);
+
 	if (!app.Initialize()) {
 		return 1;
 	}
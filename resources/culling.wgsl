@@ -0,0 +1,111 @@
+// Included by shader.wgsl when the geometry has meshlets (MESHLET_CULLING).
+// Relies on modelToView(), the uniforms, near and far from there. Meshlets
+// are culled for the first instance, the only one drawn when they are.
+
+/**
+ * GPU cluster culling. One workgroup handles one meshlet: the first thread
+ * tests it against the view frustum and its normal cone and, if it survives,
+ * reserves room for its indices in the compacted index buffer that the
+ * render pass then draws with DrawIndexedIndirect.
+ */
+struct Meshlet {
+	center: vec3f,
+	radius: f32,
+	coneAxis: vec3f,
+	coneCutoff: f32,
+	indexOffset: u32,
+	indexCount: u32,
+};
+
+struct DrawIndexedIndirectArgs {
+	indexCount: atomic<u32>,
+	instanceCount: u32,
+	firstIndex: u32,
+	baseVertex: i32,
+	firstInstance: u32,
+};
+
+// Meshlets of the level of detail being drawn
+struct CullParams {
+	meshletOffset: u32,
+	meshletCount: u32,
+};
+
+// Whether the source index buffer holds 16-bit indices, two per u32
+override sourceIndexUint16: bool = false;
+// Normal cone culling is only valid when the render pipeline culls back faces
+override coneCulling: bool = false;
+
+@group(1) @binding(0) var<storage, read> meshlets: array<Meshlet>;
+@group(1) @binding(1) var<storage, read> sourceIndices: array<u32>;
+@group(1) @binding(2) var<storage, read_write> culledIndices: array<u32>;
+@group(1) @binding(3) var<storage, read_write> drawArgs: DrawIndexedIndirectArgs;
+@group(1) @binding(4) var<uniform> cullParams: CullParams;
+
+const cullWorkgroupSize = 64u;
+const culled = 0xffffffffu;
+var<workgroup> culledIndexBase: u32;
+
+fn loadSourceIndex(i: u32) -> u32 {
+	if (sourceIndexUint16) {
+		let word = sourceIndices[i / 2u];
+		return select(word & 0xffffu, word >> 16u, (i & 1u) == 1u);
+	}
+	return sourceIndices[i];
+}
+
+fn isMeshletVisible(meshlet: Meshlet) -> bool {
+	let modelView = instances[0u].modelViewMatrix;
+	let center = modelToView(0u, meshlet.center);
+	// The model view transform is a similarity, so it scales all lengths the
+	// same way as its first axis
+	let scale = length(modelView[0].xyz);
+	let radius = meshlet.radius * scale;
+
+	// Frustum of the perspective projection: |xScale * x| <= z,
+	// |yScale * y| <= z and near <= z <= far
+	let xScale = uMyUniforms.projectionMatrix[0][0];
+	let yScale = uMyUniforms.projectionMatrix[1][1];
+	let sideLength = sqrt(xScale * xScale + 1.0);
+	let topLength = sqrt(yScale * yScale + 1.0);
+	if (xScale * center.x - center.z > radius * sideLength) { return false; }
+	if (-xScale * center.x - center.z > radius * sideLength) { return false; }
+	if (yScale * center.y - center.z > radius * topLength) { return false; }
+	if (-yScale * center.y - center.z > radius * topLength) { return false; }
+	if (center.z + radius < near || center.z - radius > far) { return false; }
+
+	// Back-facing cluster: the camera (the view space origin) is behind
+	// every triangle of the cone
+	if (coneCulling) {
+		let axis = (modelView * vec4f(meshlet.coneAxis, 0.0)).xyz / scale;
+		if (dot(center, axis) >= meshlet.coneCutoff * length(center) + radius) { return false; }
+	}
+	return true;
+}
+
+@compute @workgroup_size(cullWorkgroupSize)
+fn cs_cull(
+	@builtin(workgroup_id) workgroupId: vec3u,
+	@builtin(num_workgroups) workgroupCount: vec3u,
+	@builtin(local_invocation_index) localIndex: u32,
+) {
+	// Workgroups are dispatched in 2D when there are more meshlets than the
+	// maximum number of workgroups per dimension
+	let meshletIndex = workgroupId.x + workgroupId.y * workgroupCount.x;
+	if (meshletIndex >= cullParams.meshletCount) { return; }
+	let meshlet = meshlets[cullParams.meshletOffset + meshletIndex];
+
+	if (localIndex == 0u) {
+		var base = culled;
+		if (isMeshletVisible(meshlet)) {
+			base = atomicAdd(&drawArgs.indexCount, meshlet.indexCount);
+		}
+		culledIndexBase = base;
+	}
+	let base = workgroupUniformLoad(&culledIndexBase);
+	if (base == culled) { return; }
+
+	for (var i = localIndex; i < meshlet.indexCount; i += cullWorkgroupSize) {
+		culledIndices[base + i] = loadSourceIndex(meshlet.indexOffset + i);
+	}
+}
@@ -1,5 +1,8 @@
 // In a new file 'resources/shader.wgsl'
 // Move the content of the global `shaderSource` variable (and remove that variable from main.cpp)
+// This file goes through ShaderPreprocessor, whose defines are set from
+// the ShaderFeatures of the variant being built. Toggles and values that
+// do not change the declarations are overrides instead, set per pipeline.
 /**
  * A structure with fields labeled with vertex attribute locations can be used
  * as input to the entry point of a shader.
@@ -19,101 +22,79 @@ struct VertexOutput {
 	// that this field must be handled by the rasterizer.
 	// (It can also refer to another field of another struct that would be used
 	// as input to the fragment shader.)
-	@location(0) color: vec3f,
+	@location(0) color: vec4f,
 };
 
 /**
- * A structure holding the value of our uniforms
+ * A structure holding the value of our uniforms, shared by every copy of
+ * the mesh drawn in a frame
  */
 struct MyUniforms {
-    color: vec4f,
-    time: f32
+    projectionMatrix: mat4x4f,
+    // Quantized positions (Snorm16 or Float16) are stored relative to the
+    // mesh bounding box, this brings them back to model space
+    positionScale: vec4f,
+    positionBias: vec4f,
+};
 
+/**
+ * What differs between the copies of the mesh drawn by a single instanced
+ * draw. Matrices are computed once per frame on the CPU (see
+ * Application::UpdateTransforms()).
+ */
+struct Instance {
+    // Model space to clip space, i.e. projection * view * model
+    modelViewProjectionMatrix: mat4x4f,
+    // Model space to view space, where the camera sits at the origin and
+    // looks towards +Z
+    modelViewMatrix: mat4x4f,
+    // Multiplies the vertex colors
+    color: vec4f,
 };
 
 
 @group(0) @binding(0)
 var<uniform> uMyUniforms: MyUniforms;
 
-const pi = 3.14159265359;
-@vertex
-fn vs_main(in: VertexInput) -> VertexOutput {
-	var out: VertexOutput;
-	let ratio = 640.0 / 480.0;
-	var position = in.position;
-	
-	// Scale the object
-	let S = transpose(mat4x4f(
-		0.3,  0.0, 0.0, 0.0,
-		0.0,  0.3, 0.0, 0.0,
-		0.0,  0.0, 0.3, 0.0,
-		0.0,  0.0, 0.0, 1.0,
-	));
-	
-	// Translate the object
-	let T = transpose(mat4x4f(
-		1.0,  0.0, 0.0, 0.5,
-		0.0,  1.0, 0.0, 0.0,
-		0.0,  0.0, 1.0, 0.0,
-		0.0,  0.0, 0.0, 1.0,
-	));
-	
-	// Rotate the model in the XY plane
-	let angle1 = uMyUniforms.time;
-	let c1 = cos(angle1);
-	let s1 = sin(angle1);
-	let R1 = transpose(mat4x4f(
-		 c1,  s1, 0.0, 0.0,
-		-s1,  c1, 0.0, 0.0,
-		0.0, 0.0, 1.0, 0.0,
-		0.0,  0.0, 0.0, 1.0,
-	));
-	
-	// Tilt the view point in the YZ plane
-	// by three 8th of turn (1 turn = 2 pi)
-	let angle2 = 3.0 * pi / 4.0;
-	let c2 = cos(angle2);
-	let s2 = sin(angle2);
-	let R2 = transpose(mat4x4f(
-		1.0, 0.0, 0.0, 0.0,
-		0.0,  c2,  s2, 0.0,
-		0.0, -s2,  c2, 0.0,
-		0.0,  0.0, 0.0, 1.0,
-	));
-	
-	let homogeneous_position = vec4f(position, 1.0);
-	position = (R2 * R1 * T * S * homogeneous_position).xyz;
-
-	// We move the view point so that all Z coordinates are > 0
-	// (this did not make a difference with the orthographic projection
-	// but does now.)
+// Visible copies of the mesh, indexed by @builtin(instance_index)
+@group(0) @binding(1)
+var<storage, read> instances: array<Instance>;
 
-	let focalPoint = vec3f(0.0, 0.0, -2.0);
-	position = position - focalPoint;
+// Set from Application::ShaderConstants() when pipelines are created, and
+// folded by the compiler like consts
+// Positions are quantized relative to the mesh bounds
+override quantizedPositions: bool = false;
+// Clipping planes of the camera
+override near: f32 = 0.01;
+override far: f32 = 100.0;
 
-	// We divide by the Z coord
-	position.x /= position.z;
-	position.y /= position.z;
-
-	let near = 0.0;
-	let far = 100.0;
-	let scale = 1.0;
+/**
+ * Move a model space position of an instance to view space. This is shared
+ * by the vertex shader and the culling pass, so that both agree on what is
+ * visible.
+ */
+fn modelToView(instance: u32, modelPosition: vec3f) -> vec3f {
+	return (instances[instance].modelViewMatrix * vec4f(modelPosition, 1.0)).xyz;
+}
 
-	let P = transpose(mat4x4f(
-    1.0 / scale,      0.0,           0.0,                  0.0,
-        0.0,     ratio / scale,      0.0,                  0.0,
-        0.0,          0.0,      1.0 / (far - near), -near / (far - near),
-        0.0,          0.0,           0.0,                  1.0,
-));
-	
-	// Apply viewport transform "the old way", we'll see a proper matrix-based way in next chapter
-	out.position = P * vec4f(position, 1.0);
-	out.color = in.color;
+@vertex
+fn vs_main(in: VertexInput, @builtin(instance_index) instance: u32) -> VertexOutput {
+	var out: VertexOutput;
+	var position = in.position;
+	if (quantizedPositions) {
+		position = uMyUniforms.positionBias.xyz + in.position * uMyUniforms.positionScale.xyz;
+	}
+	out.position = instances[instance].modelViewProjectionMatrix * vec4f(position, 1.0);
+	out.color = vec4f(in.color, 1.0) * instances[instance].color;
 	return out;
 }
 
 @fragment
 // Or we can use a custom struct whose fields are labeled
 fn fs_main(in: VertexOutput) -> @location(0) vec4f {
-	return vec4f(in.color, 1.0) * uMyUniforms.color; // use the interpolated color coming from the vertex shader
-}
\ No newline at end of file
+	return in.color; // use the interpolated color coming from the vertex shader
+}
+
+#ifdef MESHLET_CULLING
+#include "culling.wgsl"
+#endif
@@ -0,0 +1,102 @@
+// Pack a resource directory into a single ResourcePack archive.
+//
+// Usage: ResourcePacker [--compress] <resource directory> <output pack>
+//
+// Every file below the directory is packed under its '/' separated path
+// relative to it, except for hidden files and directories (like the asset
+// cache in `.cache`). With --compress, entries are LZ4 compressed whenever
+// it makes them at least an eighth smaller. The App mounts
+// `<resource directory>.pack` instead of the loose files when it exists.
+#include "ResourcePack.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <system_error>
+#include <vector>
+
+namespace
+{
+	void printUsage()
+	{
+		std::cerr << "Usage: ResourcePacker [--compress] <resource directory> <output pack>" << std::endl;
+	}
+
+	bool isHidden(const std::filesystem::path& relativePath)
+	{
+		for (const std::filesystem::path& part : relativePath) {
+			std::string name = part.string();
+			if (!name.empty() && name[0] == '.' && name != "." && name != "..") return true;
+		}
+		return false;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	bool compress = false;
+	std::vector<std::string> arguments;
+	for (int i = 1; i < argc; ++i) {
+		if (std::strcmp(argv[i], "--compress") == 0) {
+			compress = true;
+		}
+		else {
+			arguments.push_back(argv[i]);
+		}
+	}
+	if (arguments.size() != 2) {
+		printUsage();
+		return 1;
+	}
+
+	const std::filesystem::path directory = arguments[0];
+	const std::filesystem::path packPath = arguments[1];
+	std::error_code ec;
+	if (!std::filesystem::is_directory(directory, ec)) {
+		std::cerr << directory << " is not a directory" << std::endl;
+		return 1;
+	}
+
+	std::vector<ResourcePack::Source> sources;
+	for (auto it = std::filesystem::recursive_directory_iterator(directory, ec); !ec && it != std::filesystem::recursive_directory_iterator(); it.increment(ec)) {
+		std::filesystem::path relativePath = it->path().lexically_relative(directory);
+		if (isHidden(relativePath)) {
+			if (it->is_directory()) it.disable_recursion_pending();
+			continue;
+		}
+		if (!it->is_regular_file()) continue;
+		// In case the pack is written inside the directory
+		std::error_code packError;
+		if (std::filesystem::equivalent(it->path(), packPath, packError)) continue;
+		sources.push_back({ relativePath.generic_string(), it->path() });
+	}
+	if (ec) {
+		std::cerr << "Could not list " << directory << ": " << ec.message() << std::endl;
+		return 1;
+	}
+
+	// Deterministic output whatever the order of the directory listing
+	std::sort(sources.begin(), sources.end(), [](const ResourcePack::Source& a, const ResourcePack::Source& b) {
+		return a.name < b.name;
+	});
+	if (!ResourcePack::write(packPath, sources, compress)) {
+		return 1;
+	}
+
+	ResourcePack pack;
+	if (!pack.open(packPath)) {
+		return 1;
+	}
+	uint64_t size = 0, storedSize = 0;
+	for (size_t i = 0; i < pack.entryCount(); ++i) {
+		size += pack.entry(i).size;
+		storedSize += pack.entry(i).storedSize;
+	}
+	std::cout
+		<< "Packed " << pack.entryCount() << " resources into " << packPath << ": "
+		<< size << " bytes, " << storedSize << " stored"
+		<< std::endl;
+	return 0;
+}